@@ -1,57 +1,150 @@
 #pragma once
 
 #include "core.h"
-#include "duck.h"
+#include "damage_tracker.h"
+#include "duck_system.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+#include "gpu_timer.h"
 #include "interactive_pool.h"
+#include "job_system.h"
 #include "particle_system.h"
+#include "platform.h"
 #include "pool.h"
+#include "profiler.h"
+#include "quality_governor.h"
 #include "raylib.h"
+#include "sprite_batch.h"
+#include "texture_atlas.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace Rain {
 
+struct ApplicationOptions {
+  int quit_timeout = 5 * 60;
+  int min_particles = 0;
+  int max_particles = 1000;
+  ParticleSystemMode rain_mode = ParticleSystemMode::Simulated;
+  WaveSolver wave_solver = WaveSolver::Explicit;
+  // Coarsens calm stretches of the water, with WaveSolver::Implicit only
+  bool adaptive_water = false;
+  // Wave points across the pool at full quality
+  int water_resolution = 300;
+  bool headless = false;
+  HeadlessPlatformOptions headless_options;
+  float simulation_rate = 144;
+  int max_simulation_steps = 5;
+  // Job workers besides the main thread, -1 picks one per spare core
+  int worker_threads = -1;
+  // Chrome trace written on exit, none when empty. F2 writes it at any time.
+  std::string trace_path;
+  // Per-zone timings on screen, F3 toggles them
+  bool profiler_overlay = false;
+  // Frame time the quality governor keeps the overlay under, 0 disables it
+  float frame_budget_ms = 0;
+  // Headless runs fail when the foreground damage averages more than this
+  // percentage of the screen, 0 disables the check
+  float max_damage_percent = 0;
+};
+
 class Application {
+
   Color RAIN_COLOR = Color{15, 94, 156, 200};
   Color WATER_COLOR = Color{15, 94, 156, 200};
   Color FOAM_COLOR = Color{5, 48, 82, 60};
   float FOAM_WIDTH = 0.01f;
   float WATER_HEIGHT_GROWTH_RATE = 25.0f;
   float RAIN_OFFSET = 500.0f;
+  const char *DEFAULT_TRACE_PATH = "rain_trace.json";
+  constexpr static float MIN_RENDER_SCALE = 0.5f;
 
 public:
-  Application(int quit_timeout, int min_particles, int max_particles);
+  Application(const ApplicationOptions &options);
   ~Application();
 
   void Init();
   void Run();
 
+  // Non-zero when a headless run failed a check
+  int exit_code() const { return m_exit_code; }
+
 private:
+  std::unique_ptr<Platform> m_platform;
+  std::unique_ptr<JobSystem> m_jobs;
   std::unique_ptr<ParticleSystem> m_rain;
   std::unique_ptr<Pool> m_pool;
   std::unique_ptr<InteractivePool> m_interactive_pool;
-  std::unique_ptr<Duck> m_duck;
-  std::vector<std::unique_ptr<Duck>> m_ducks;
+  std::unique_ptr<DuckSystem> m_ducks;
+  std::unique_ptr<SpriteBatch> m_sprite_batch;
+  // Only created when the profiler is compiled in and the driver has timer
+  // queries
+  std::unique_ptr<GpuTimer> m_gpu_timer;
 
   Shader m_rain_shader;
   Shader m_pool_shader;
+  Shader m_water_shader;
 
   Texture m_default_texture;
-  Texture m_duck_texture;
+  TextureAtlas m_atlas;
+  int m_duck_region = -1;
 
   RenderTexture m_foreground;
+  // Regions of m_foreground rain and water changed, in screen coordinates
+  DamageTracker m_foreground_damage;
+  std::vector<Rectangle> m_rain_rects;
+  std::vector<Rectangle> m_damage_pixels;
 
   int m_quit_timeout;
   int m_min_particles;
   int m_max_particles;
+  ParticleSystemMode m_rain_mode;
+  WaveSolver m_wave_solver;
+  bool m_adaptive_water;
+  int m_water_resolution;
+  bool m_headless;
+  HeadlessPlatformOptions m_headless_options;
+  FrameStats m_update_stats;
+  float m_simulation_rate;
+  // Rate of the current frame state, lower than m_simulation_rate in the
+  // background
+  float m_step_rate;
+  bool m_simulation_paused = false;
+  FrameScheduler m_scheduler{FrameSchedulerOptions{}};
+  int m_max_simulation_steps;
+  int m_worker_threads;
+  std::string m_trace_path;
+  bool m_profiler_overlay;
+  QualityGovernor m_governor;
+  float m_max_damage_percent;
+  // Percentages of the screen damaged per headless frame, summed
+  double m_damage_percent_sum = 0;
+  int m_exit_code = 0;
+  // Fraction of the foreground resolution rendered, the rest is upscaled
+  float m_render_scale = 1.0f;
+  float m_accumulator = 0;
 
   float timeout_counter = 0;
 
   bool m_should_close = false;
 
+  void RunWindowed();
+  void ApplyFrameState();
   void Update();
+  void Step(float dt);
+  void SetRenderAlpha(float alpha);
+  void RunHeadless();
+  void ReportFrameStats();
+  void HandleProfilerKeys();
+  void WriteTrace(const std::string &path);
+  void DrawProfilerOverlay();
+  void UpdateQuality(double cpu_ms);
+  void ApplyQuality(float level);
   void Draw();
   void DrawBackground();
+  void TrackForegroundDamage();
   void DrawForeground();
   void Teardown();
   void SetupWindow();
@@ -60,7 +153,7 @@ private:
   ParticleSystem *CreateRainParticleSystem(Shader shader);
   Pool *CreatePool(Shader shader, Texture texture);
   InteractivePool *CreateInteractivePool(Shader shader, Texture texture);
-  Duck *CreateDuck(Texture texture);
+  DuckSystem *CreateDuckSystem();
 };
 
 }; // namespace Rain
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <raylib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Rain {
+
+// Smallest rectangle covering both, a rectangle with no area counts as empty
+Rectangle RectangleUnion(Rectangle a, Rectangle b);
+bool IsRectangleEmpty(Rectangle rect);
+
+// Tracks which part of a render target that persists between frames has to
+// be redrawn. Systems report the regions whose pixels changed and the regions
+// they cover. Damage is kept per tile, so scattered small regions such as
+// rain drops do not grow into one rectangle spanning all of them. Pixels
+// damaged last frame may still hold what was drawn there, so the damage of a
+// frame is united with the previous frame's.
+class DamageTracker {
+public:
+  const static int TILE_SIZE = 32;
+  // Every rectangle costs a scissored clear. Above this many, rows of tiles
+  // are merged into bands.
+  const static size_t MAX_DAMAGE_RECTS = 256;
+
+  DamageTracker();
+  DamageTracker(Rectangle bounds);
+
+  void AddDamage(Rectangle rect);
+  void AddContent(Rectangle rect);
+  // Damages the whole target, e.g. after it was resized or rescaled
+  void Invalidate();
+
+  // Disjoint rectangles to clear and redraw this frame, clipped to the bounds
+  // and aligned to tiles
+  const std::vector<Rectangle> &damage();
+  // Region the target holds anything in, clipped to the bounds
+  Rectangle content() const;
+
+  void EndFrame();
+
+private:
+  // Damaged tiles [begin, end) of a row and the rectangle they extend
+  struct Run {
+    int begin;
+    int end;
+    size_t rect;
+  };
+
+  Rectangle m_bounds;
+  int m_columns;
+  int m_rows;
+  std::vector<uint8_t> m_tiles;
+  std::vector<uint8_t> m_previous_tiles;
+  std::vector<Rectangle> m_damage;
+  std::vector<Run> m_runs;
+  std::vector<Run> m_previous_runs;
+  Rectangle m_content;
+  bool m_invalidated;
+
+  bool MergeRuns(bool bands, int band);
+  // Whether the tile is damaged in any of `rows` rows from `row` on
+  bool IsTileDamaged(int column, int row, int rows) const;
+  Rectangle Clip(Rectangle rect) const;
+};
+
+}; // namespace Rain
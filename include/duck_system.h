@@ -0,0 +1,71 @@
+#pragma once
+
+#include "entity.h"
+#include "interactive_pool.h"
+#include "job_system.h"
+#include "raylib.h"
+#include "rigidbody_2d.h"
+#include "spatial_hash.h"
+#include "sprite_batch.h"
+
+#include <vector>
+
+namespace Rain {
+
+struct DuckSystemOptions {
+  JobSystem *jobs;
+  InteractivePool *interactive_pool;
+  // Duck frame inside the sprite batch texture
+  Rectangle sprite_source;
+  Vector2 size;
+  float mass;
+};
+
+// Every duck as a set of components in contiguous arrays, indexed by duck:
+// transforms, rigid bodies and sprites. Updates are sweeps over ranges of
+// these arrays instead of calls through per-duck objects.
+class DuckSystem {
+public:
+  const static size_t UPDATE_CHUNK_SIZE = 64;
+  // Has to be at least the duck size for the broadphase to find every overlap
+  constexpr static float GRID_CELL_SIZE = 256.0f;
+  constexpr static float RESTITUTION = 0.2f;
+
+  // Fraction of a simulation step elapsed since the last OnUpdate
+  float render_alpha = 1.0f;
+
+  DuckSystem(const DuckSystemOptions &options);
+
+  // Adds a duck centered on position and returns its index
+  size_t Spawn(Vector2 position);
+
+  void OnUpdate(float dt);
+  void OnDraw(SpriteBatch &batch);
+
+  size_t count() const { return m_transforms.size(); }
+
+private:
+  DuckSystemOptions m_options;
+
+  std::vector<Transform> m_transforms;
+  std::vector<Vector2> m_previous_positions;
+  std::vector<Rigidbody2d> m_bodies;
+  std::vector<Sprite> m_sprites;
+
+  // Per-duck scratch for the batched water queries, each update chunk only
+  // touches its own slice
+  std::vector<WaterSampleRange> m_sample_ranges;
+  std::vector<float> m_wave_ys;
+
+  SpatialHash m_grid{GRID_CELL_SIZE};
+  std::vector<int> m_neighbors;
+
+  Vector2 GetCenter(size_t index) const;
+
+  void UpdateRange(float dt, size_t begin, size_t end);
+  void ApplyBuoyancy(size_t begin, size_t end);
+  void ResolveCollisions();
+  void ResolveCollision(size_t a, size_t b);
+};
+
+}; // namespace Rain
@@ -10,13 +10,16 @@ struct Transform {
   float rotation = 0.0f;
 };
 
+// State shared by the scene objects. There is no virtual interface: every
+// owner holds its objects by their concrete type and calls Init, OnUpdate and
+// OnDraw directly.
 class Entity {
 public:
   Transform transform;
 
-  virtual void Init() = 0;
-  virtual void OnUpdate(float dt) = 0;
-  virtual void OnDraw() = 0;
+  // Fraction of a simulation step elapsed since the last OnUpdate, used by
+  // OnDraw to interpolate between the previous and the current state
+  float render_alpha = 1.0f;
 };
 
 }; // namespace Rain
\ No newline at end of file
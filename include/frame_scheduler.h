@@ -0,0 +1,45 @@
+#pragma once
+
+#include "platform.h"
+
+namespace Rain {
+
+enum class FrameState {
+  // Someone is interacting with the overlay: full frame and simulation rate
+  Active,
+  // The overlay is only decoration: lower frame and simulation rate
+  Background,
+  // Nothing is visible: the simulation pauses and frames only poll events
+  Idle
+};
+
+struct FrameSchedulerOptions {
+  int active_fps = 144;
+  int background_fps = 30;
+  int idle_fps = 4;
+  float background_simulation_rate = 60;
+  // Seconds without input before an unfocused overlay goes to the background
+  float background_delay = 5;
+};
+
+// Picks the frame state from the window state and input. Input switches back
+// to Active on the frame it arrives.
+class FrameScheduler {
+public:
+  FrameScheduler(const FrameSchedulerOptions &options);
+
+  // Returns true when the state changed
+  bool Update(Platform &platform, float frame_time);
+
+  FrameState state() const { return m_state; }
+  int target_fps() const;
+  // Simulation rate for the current state, given the rate when active
+  float SimulationRate(float active_rate) const;
+
+private:
+  FrameSchedulerOptions m_options;
+  FrameState m_state = FrameState::Active;
+  float m_time_since_input = 0;
+};
+
+}; // namespace Rain
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Rain {
+
+// Collects per-frame durations in milliseconds and summarizes them.
+class FrameStats {
+public:
+  void Add(double ms) { m_samples.push_back(ms); }
+
+  size_t count() const { return m_samples.size(); }
+  double Mean() const;
+  double Max() const;
+  double Percentile(double p) const;
+
+private:
+  std::vector<double> m_samples;
+};
+
+}; // namespace Rain
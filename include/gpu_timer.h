@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Rain {
+
+// Times render passes on the GPU with timestamp queries and reports them to
+// the Profiler on a "GPU" track. Queries of a frame are only read back
+// FRAME_LATENCY frames later, and only when the GPU already has the results,
+// so the CPU never waits on them.
+class GpuTimer {
+public:
+  const static int FRAME_LATENCY = 4;
+  const static int MAX_PASSES = 8;
+
+  // Needs a GL context; IsSupported tells whether the driver has the queries
+  GpuTimer();
+  ~GpuTimer();
+
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  bool IsSupported() const { return m_supported; }
+
+  // Reads back the oldest frame in flight and starts recording a new one
+  void BeginFrame();
+
+  // Passes must not overlap. Names must be string literals.
+  void BeginPass(const char *name);
+  void EndPass();
+
+  // Span from the first pass start to the last pass end of the newest frame
+  // read back
+  double last_frame_ms() const { return m_last_frame_ms; }
+
+private:
+  struct Frame {
+    // Start and end timestamp of every pass
+    unsigned int queries[2 * MAX_PASSES];
+    const char *names[MAX_PASSES];
+    int pass_count = 0;
+  };
+
+  bool m_supported = false;
+  Frame m_frames[FRAME_LATENCY];
+  uint64_t m_frame = 0;
+  // Profiler time minus GPU time, both in nanoseconds
+  int64_t m_clock_offset_ns = 0;
+  double m_last_frame_ms = 0;
+
+  Frame &CurrentFrame() { return m_frames[m_frame % FRAME_LATENCY]; }
+  void ReadBack(Frame &frame);
+};
+
+// Times the enclosing scope as one pass.
+class GpuPass {
+public:
+  GpuPass(GpuTimer *timer, const char *name) : m_timer(timer) {
+    if (m_timer != nullptr) {
+      m_timer->BeginPass(name);
+    }
+  }
+  ~GpuPass() {
+    if (m_timer != nullptr) {
+      m_timer->EndPass();
+    }
+  }
+
+  GpuPass(const GpuPass &) = delete;
+  GpuPass &operator=(const GpuPass &) = delete;
+
+private:
+  GpuTimer *m_timer;
+};
+
+}; // namespace Rain
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <core.h>
+#include <material.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace Rain {
+
+// Constants of one simulation step, in the units of InteractivePool
+struct GpuWaterStep {
+  float dt;
+  float spring_constant;
+  float baseline_constant;
+  float damping;
+  // Offset every point is pulled back to
+  float rest;
+  // Screen center of the pool, and x of the first point relative to it
+  Vector2 center;
+  float first_x;
+  float column_width;
+  // One background wave per component
+  Vector4 wave_amplitudes;
+  Vector4 wave_numbers;
+  Vector4 wave_phases;
+};
+
+// Velocity pushed into the points [begin, end) by an interactor
+struct GpuWaterSplat {
+  int begin;
+  int end;
+  Vector2 position;
+  float radius;
+  float strength;
+  float max_influence;
+};
+
+// Spring chain stepped on the GPU. Point state lives in a row of float
+// texels, (offset, velocity, offset + background waves, 1), that fragment
+// passes ping-pong between two render targets. Impulses are drawn into a
+// separate row first. A downsampled copy of the heights is read back through
+// pixel buffers, only once the GPU finished writing it, so the CPU never
+// stalls on the simulation.
+class GpuWaterSim {
+public:
+  const static int READBACK_WIDTH = 256;
+  const static int READBACK_BUFFERS = 3;
+
+  // Needs a GL context; IsSupported tells whether the driver renders to
+  // float textures and has pixel buffers and fences
+  GpuWaterSim(int capacity);
+  ~GpuWaterSim();
+
+  GpuWaterSim(const GpuWaterSim &) = delete;
+  GpuWaterSim &operator=(const GpuWaterSim &) = delete;
+
+  bool IsSupported() const { return m_supported; }
+
+  // Replaces the state with count points
+  void Upload(const std::vector<Vector4> &points);
+  // Resamples the state onto count points, keeping both ends in place
+  void Resample(int count);
+
+  // impulses holds one velocity change per point, added before the splats
+  void Step(const GpuWaterStep &step, const float *impulses,
+            const GpuWaterSplat *splats, int splat_count);
+
+  // Starts copying the heights to the CPU, unless every buffer is in flight
+  void RequestReadback();
+  // Fills ys with the newest finished readback, up to READBACK_WIDTH heights
+  // relative to the pool center evenly spread over the points. Returns false
+  // while none finished.
+  bool PollReadback(std::vector<float> &ys);
+
+  int count() const { return m_count; }
+  Texture heights() const { return m_states[m_current].texture; }
+  Texture previous_heights() const { return m_states[1 - m_current].texture; }
+
+private:
+  struct Readback {
+    unsigned int buffer = 0;
+    void *fence = nullptr;
+    int count = 0;
+  };
+
+  bool m_supported = false;
+  int m_capacity;
+  int m_count = 0;
+
+  RenderTexture m_states[2] = {};
+  int m_current = 0;
+  RenderTexture m_impulses = {};
+  Texture m_impulse_upload = {};
+  RenderTexture m_readback = {};
+  Readback m_readbacks[READBACK_BUFFERS];
+  uint64_t m_readback_next = 0;
+  uint64_t m_readback_oldest = 0;
+
+  Shader m_step_shader;
+  Shader m_splat_shader;
+  Shader m_resample_shader;
+  Material m_step_material;
+  Material m_splat_material;
+  Material m_resample_material;
+  int m_step_impulses_loc = -1;
+  int m_splat_state_loc = -1;
+
+  // Step uniforms
+  int m_count_uniform = -1;
+  int m_dt_uniform = -1;
+  int m_spring_uniform = -1;
+  int m_baseline_uniform = -1;
+  int m_damping_uniform = -1;
+  int m_rest_uniform = -1;
+  int m_first_x_uniform = -1;
+  int m_column_width_uniform = -1;
+  int m_amplitudes_uniform = -1;
+  int m_wave_numbers_uniform = -1;
+  int m_phases_uniform = -1;
+
+  // Splat uniforms
+  int m_splat_center_uniform = -1;
+  int m_splat_first_x_uniform = -1;
+  int m_splat_column_width_uniform = -1;
+  int m_splat_rest_uniform = -1;
+  int m_splat_position_uniform = -1;
+  int m_splat_radius_uniform = -1;
+  int m_splat_strength_uniform = -1;
+  int m_splat_max_influence_uniform = -1;
+
+  // Resample uniforms
+  int m_source_count_uniform = -1;
+  int m_target_count_uniform = -1;
+
+  void LoadMaterials();
+  void DrawImpulses(const GpuWaterStep &step, const float *impulses,
+                    const GpuWaterSplat *splats, int splat_count);
+  void ResampleRow(Texture source, int source_count, RenderTexture &target,
+                   int target_count);
+};
+
+}; // namespace Rain
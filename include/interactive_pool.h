@@ -1,17 +1,38 @@
 #pragma once
 
-#include "renderer.h"
 #include <cmath>
+#include <cstdint>
 #include <core.h>
 #include <entity.h>
+#include <gpu_water_sim.h>
+#include <job_system.h>
 #include <limits.h>
+#include <memory>
+#include <material.h>
 #include <particle.h>
+#include <platform.h>
 #include <stdlib.h>
 #include <vector>
+#include <water_surface.h>
 
 namespace Rain {
 
+enum class WaveSolver {
+  // Explicit Euler on the spring chain, cheap but unstable at large time
+  // steps and stiff springs
+  Explicit,
+  // Backward Euler with a tridiagonal solve, stable at any time step and
+  // resolution at the cost of some extra damping
+  Implicit,
+  // Fragment passes over a float texture, see GpuWaterSim. Falls back to
+  // Implicit without a window or driver support.
+  Gpu,
+};
+
 struct InteractivePoolOptions {
+  Platform *platform;
+  // Sizes the impulse rows of the surface, one per job thread
+  JobSystem *jobs;
   int resolution;
   float height_growth_rate;
   Shader shader;
@@ -20,6 +41,11 @@ struct InteractivePoolOptions {
   Color water_color;
   float foam_width;
   float max_height;
+  WaveSolver solver = WaveSolver::Explicit;
+  // Lets the implicit solver simulate calm stretches of the surface at a
+  // coarser spacing, see InteractivePool::AdaptBlocks. Ignored by the other
+  // solvers.
+  bool adaptive = false;
 };
 
 struct WavePoint {
@@ -27,23 +53,61 @@ struct WavePoint {
   Vector2 velocity;
   Vector2 offset;
   Vector2 final_position;
+  Vector2 previous_final_position;
+};
+
+// Pushes the surface down around a point, e.g. the mouse.
+struct WaveInteractor {
+  Vector2 position;
+  float radius;
+  float force;
 };
 
-struct WaveRenderData {
-  std::vector<Vector2> vertices;
-  std::vector<Vector2> tex_coords;
+struct WaterSampleRange {
+  float min_x;
+  float max_x;
 };
 
 class InteractivePool : public Entity {
 public:
   const static int MAX_BACKGROUND_WAVES = 3;
-  const static int MIN_POINTS_UNDER_MOUSE = 0;
+  const static int MOUSE_INTERACTOR = 0;
   constexpr static float INFLUENCE_RADIUS = 200.0;
   constexpr static float MAX_INFLUENCE_DIST = 300.0;
   constexpr static float SPRING_CONSTANT = 4;
   constexpr static float SPRING_BASELINE_CONSTANT = 2;
   constexpr static float SPRING_DAMPING_CONSTANT = 0.001;
+  // Rate at which SPRING_DAMPING_CONSTANT was tuned as a per-step factor
+  constexpr static float SPRING_DAMPING_REFERENCE_RATE = 144;
   constexpr static float INFLUENCE_FORCE = 150;
+  // Fraction of an impulse added to the surface velocity, i.e. the mass of a
+  // drop relative to a wave point
+  constexpr static float IMPACT_RESPONSE = 0.002;
+  // Heights read back from the GPU lag a few steps behind the drawn surface,
+  // so its bounds are widened by this much
+  constexpr static float GPU_BOUNDS_MARGIN = 32;
+  // The surface is split into blocks of this many segments, which sleep on
+  // their own and, when adaptive, simulate every (1 << level)-th point up to
+  // MAX_ADAPTIVE_LEVEL
+  const static int BLOCK_SIZE = 16;
+  const static int MAX_ADAPTIVE_LEVEL = 3;
+  const static int MAX_BODY_LEVEL = 2;
+  // Interpolation error, in pixels, above which a block refines and below
+  // which it coarsens
+  constexpr static float REFINE_ERROR = 0.5;
+  constexpr static float COARSEN_ERROR = 0.125;
+  // Velocities count as the offset they build up over this many seconds
+  constexpr static float ERROR_LOOKAHEAD = 0.1;
+  const static int COARSEN_INTERVAL = 16;
+  // A block whose offsets and velocities stay within these of rest for
+  // SLEEP_DELAY seconds stops being integrated until something disturbs it
+  constexpr static float SLEEP_OFFSET = 0.5;
+  constexpr static float SLEEP_VELOCITY = 2;
+  constexpr static float SLEEP_DELAY = 0.5;
+  // rlgl draws indexed meshes with 16 bit indices. The mesh has two vertices
+  // per wave point, so it holds at most 32768 wave points.
+  const static int MAX_MESH_VERTICES = 65536;
+  const static int MIN_RESOLUTION = 16;
 
   InteractivePool();
   InteractivePool(const InteractivePoolOptions &options);
@@ -51,51 +115,188 @@ public:
   void Init();
   void OnDraw();
   void OnUpdate(float dt);
+  void Unload();
 
   void SetWaterColor(Color color);
   void SetFoamColor(Color color);
 
-  std::vector<float> normalized_foam_color();
-  std::vector<float> normalized_water_color();
+  // Resamples the surface onto resolution segments, at most the resolution the
+  // pool was created with. Storage and GPU buffers are sized for that maximum,
+  // so changing it does not reallocate.
+  void SetResolution(int resolution);
+  int resolution() const { return m_resolution; }
+  // Solver that actually runs, Implicit once the GPU one fell back
+  WaveSolver solver() const { return m_solver; }
+  // Points the last step integrated, the rest were interpolated between them
+  // or asleep
+  size_t simulated_points() const { return m_simulated_points; }
 
   float GetBackgroundWaveHeightAt(const float &x);
-  float ComputeWave(float x, float t, float amplitude, float wave_length,
-                    float frequency, float phase);
+  float ComputeWave(float x, float amplitude, float wave_length, float phase);
   float SampleYFromRange(float min_x, float max_x);
+  void SampleYFromRanges(const WaterSampleRange *ranges, float *sample_ys,
+                         size_t count);
+  // Keeps the surface under these ranges resolved on the next step, see
+  // MAX_BODY_LEVEL. Not thread safe, unlike the samplers.
+  void AddFloatingBodies(const WaterSampleRange *ranges, size_t count);
 
   Vector2 GetClosestPointTo(const Vector2 &point);
 
+  int AddInteractor(const WaveInteractor &interactor);
+  WaveInteractor &interactor(int index) { return m_interactors[index]; }
+
   void UpdateWavePoints(float dt);
 
+  // Surface other systems collide with and add impulses to
+  WaterSurface &surface() { return m_surface; }
+  // Publishes the current heights and gathers the impulses added since the
+  // last call. Runs between steps, while nothing else touches the surface.
+  void SyncSurface();
+  // Runs the steps OnUpdate queued for the GPU solver, which can only issue
+  // GL calls from the main thread. Call between steps.
+  void RunGpuSteps();
+
   Vector2 GetCenterPoint();
 
-  void BindShaderValue(const char *name, void *value, int uniformType);
+  // Screen rectangle the next OnDraw covers
+  Rectangle GetDrawBounds();
+  // Part of GetDrawBounds whose pixels differ from the frame of the previous
+  // call: the band the surface moves through, or everything once the pool
+  // itself moved or was resampled. Call once per frame.
+  Rectangle GetDamageBounds();
 
 private:
+  Platform *m_platform;
   int m_resolution;
+  int m_max_resolution;
   float m_height_growth_rate;
   Shader m_shader;
+  Material m_material;
+  int m_mvp_uniform = -1;
+  int m_water_color_uniform = -1;
+  int m_foam_color_uniform = -1;
+  int m_gpu_heights_uniform = -1;
+  int m_center_y_uniform = -1;
+  int m_render_alpha_uniform = -1;
   Texture m_texture;
   Color m_foam_color;
   Color m_water_color;
   float m_foam_width;
   float m_max_height;
-  float m_total_time = 0;
+  Transform m_previous_transform;
   std::vector<WavePoint> m_wave_points;
+  std::vector<WavePoint> m_resample_scratch;
+  std::vector<WaveInteractor> m_interactors;
   float m_waves_parameters[MAX_BACKGROUND_WAVES][4] = {
       {5, 400, 1, 10.0}, {4, 500, 1, 10.0}, {2, 600, 1, 10.0}};
+  // phase - frequency * t of every wave, kept wrapped to [0, 2 * PI)
+  double m_wave_phases[MAX_BACKGROUND_WAVES];
+  std::vector<float> m_background_heights;
+  // m_height_prefix[i] is the sum of final_position.y over points [0, i)
+  std::vector<double> m_height_prefix;
+  WaveSolver m_solver;
+  // Forward sweep of the tridiagonal solve: modified upper diagonal and right
+  // hand side
+  std::vector<float> m_solver_upper;
+  std::vector<float> m_solver_rhs;
+  // Level of every adaptive block and the points it simulates, with the
+  // mass each of them stands for and the impulses gathered onto them. Without
+  // adaptivity every block stays at level 0.
+  bool m_adaptive;
+  std::vector<int> m_block_levels;
+  std::vector<int> m_next_block_levels;
+  uint64_t m_adapt_steps = 0;
+  // Coarsest level interactors and floating bodies leave every block
+  std::vector<int> m_block_max_levels;
+  std::vector<size_t> m_active_points;
+  std::vector<float> m_active_masses;
+  std::vector<float> m_active_impulses;
+  // Ranges floating bodies sampled since the last adaptation
+  std::vector<WaterSampleRange> m_body_ranges;
+  // m_block_first_active[b] is the first active point index of block b, with
+  // one past the last block as the end
+  std::vector<size_t> m_block_first_active;
+  // Sleeping blocks hold their points at rest and are skipped by the solvers
+  std::vector<bool> m_block_asleep;
+  std::vector<float> m_block_calm_time;
+  size_t m_simulated_points = 0;
+  // Only set while the GPU solver runs. The CPU points then hold the heights
+  // read back from it, for collisions and buoyancy.
+  std::unique_ptr<GpuWaterSim> m_gpu;
+  std::vector<float> m_gpu_steps;
+  std::vector<float> m_gpu_impulses;
+  std::vector<GpuWaterSplat> m_gpu_splats;
+  std::vector<float> m_gpu_readback;
+  WaterSurface m_surface;
+  std::vector<float> m_surface_ys;
+
+  // The surface is drawn from a persistent mesh: a top and a bottom vertex per
+  // wave point, with x and y in separate buffers so a frame only re-uploads
+  // the top heights. Top vertices come first and bottom vertices start at
+  // m_mesh_capacity, so any resolution draws a prefix of the index buffer.
+  unsigned int m_vao = 0;
+  unsigned int m_x_vbo = 0;
+  unsigned int m_y_vbo = 0;
+  unsigned int m_texcoord_vbo = 0;
+  unsigned int m_ebo = 0;
+  int m_mesh_capacity = 0;
+  bool m_mesh_dirty = false;
+  float m_uploaded_center_x = 0;
+  float m_uploaded_bottom_y = 0;
+  // Placement of the pool at the previous GetDamageBounds
+  float m_damage_center_x = NAN;
+  float m_damage_bottom_y = NAN;
+  int m_damage_resolution = -1;
+  std::vector<float> m_vertex_xs;
+  std::vector<float> m_vertex_ys;
+  std::vector<Vector2> m_tex_coords;
 
+  void AdvanceWavePhases(float dt);
+  void EvaluateBackgroundWaves();
+
+  void LoadRenderData();
+  void LoadMaterial();
+  void UpdateTexCoords();
+  void UploadSurface(const Transform &render_transform);
   void DrawWave();
   void DrawDebugWavePoints();
   void DrawPoints(const std::vector<Vector2> &points, float radius,
                   Color color);
 
-  int CountPointsUnderInfluence();
+  void GetPointRange(float min_x, float max_x, size_t &begin, size_t &end);
+  void GetInteractorRange(const WaveInteractor &interactor, size_t &begin,
+                          size_t &end);
+  void UpdateHeightPrefix();
+  void IntegrateExplicit(float dt);
+  void IntegrateImplicit(float dt);
+  void ResetBlocks();
+  void GetBlockRange(size_t block, size_t &begin, size_t &end);
+  bool IsBlockNearInteractor(size_t block);
+  void WakeBlocks();
+  void UpdateSleepingBlocks(float dt);
+  void SolveImplicitRun(size_t begin, size_t end, float dt);
+  void RebuildActivePoints();
+  void AdaptBlocks();
+  int GetBlockTargetLevel(size_t block, bool coarsen);
+  void GetBlockSpan(float min_x, float max_x, size_t &first, size_t &last);
+  float GetInterpolationError(size_t first, size_t end, size_t spacing,
+                              size_t stride);
+  void GatherImpulses();
+  void InterpolateInactivePoints();
+  void LoadGpuSimulation();
+  GpuWaterStep GetGpuStep(float dt);
+  void ApplyGpuReadback();
+  void ApplyInteractors(float dt);
+
+  bool IsPointUnderInfluence(const WavePoint &wave_point,
+                             const WaveInteractor &interactor);
 
-  bool IsPointUnderInfluence(const WavePoint &wave_point);
+  void ApplyWaveInfluenceForce(WavePoint &wave_point,
+                               const WaveInteractor &interactor, float dt);
 
-  void ApplyWaveInfluenceForce(WavePoint &wave_point, float dt);
+  Transform GetRenderTransform();
+  void GetRenderSurfaceRange(const Transform &render_transform, float &min_y,
+                             float &max_y);
 
-  WaveRenderData GenerateWaveRenderData();
 };
 }; // namespace Rain
\ No newline at end of file
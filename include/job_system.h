@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Rain {
+
+using Job = std::function<void()>;
+using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+// Number of jobs of a group that have not finished yet.
+struct JobCounter {
+  std::atomic<int> pending{0};
+};
+
+// Work-stealing scheduler. Every thread owns a deque: it pushes and pops jobs
+// at the back, while idle threads steal from the front of the others. The
+// thread that created the system takes part as worker 0 while it waits.
+class JobSystem {
+public:
+  JobSystem(int worker_count);
+  ~JobSystem();
+
+  void Submit(JobCounter &counter, Job job);
+  void ParallelFor(JobCounter &counter, size_t count, size_t chunk_size,
+                   RangeJob job);
+  void Wait(JobCounter &counter);
+
+  int thread_count() const { return m_queues.size(); }
+
+  // Index of the calling thread in [0, thread_count()), 0 for the main thread
+  static int CurrentThreadIndex();
+
+private:
+  struct Task {
+    Job job;
+    JobCounter *counter;
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<TaskQueue>> m_queues;
+  std::vector<std::thread> m_workers;
+  std::atomic<bool> m_running{true};
+  std::atomic<int> m_queued{0};
+  std::mutex m_wake_mutex;
+  std::condition_variable m_wake;
+
+  bool TryRunTask(int index);
+  bool PopTask(int index, Task &task);
+  bool StealTask(int index, Task &task);
+  void WorkerLoop(int index);
+};
+
+}; // namespace Rain
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <core.h>
+
+namespace Rain {
+
+// A shader together with the values of its uniforms. Locations are resolved
+// once when a uniform is added, values live in fixed-size storage, and Bind
+// uploads only the uniforms whose values changed since the previous Bind.
+//
+// Cached values are only trusted while nothing else wrote the program:
+// - Binding another material on the same shader makes the next Bind upload
+//   every value again.
+// - rlgl's own batch flushes write the MVP and texture uniforms of whatever
+//   shader they draw with, which is raylib's default shader outside of
+//   BeginShaderMode. Materials on the default shader upload every value on
+//   every Bind. Materials on other shaders must not hold uniforms rlgl
+//   writes when they are also drawn through BeginShaderMode.
+class Material {
+public:
+  const static int MAX_UNIFORMS = 16;
+  // Uniform type for 4x4 matrices, next to raylib's SHADER_UNIFORM_* types
+  const static int UNIFORM_MATRIX = -1;
+
+  Material();
+  Material(Shader shader);
+
+  Material(const Material &) = delete;
+  Material &operator=(const Material &) = delete;
+
+  int AddUniform(const char *name, int uniform_type);
+  int AddUniform(int location, int uniform_type);
+
+  void SetFloat(int uniform, float value);
+  void SetInt(int uniform, int value);
+  void SetVector2(int uniform, Vector2 value);
+  void SetVector4(int uniform, Vector4 value);
+  void SetColor(int uniform, Color color);
+  void SetMatrix(int uniform, Matrix value);
+
+  // Enables the shader and uploads the changed uniforms. The caller disables
+  // the shader, or leaves it to EndShaderMode.
+  void Bind();
+
+  Shader shader() const { return m_shader; }
+
+private:
+  struct Uniform {
+    int location;
+    int type;
+    int size;
+    float value[16];
+    bool dirty;
+  };
+
+  Shader m_shader = {};
+  Uniform m_uniforms[MAX_UNIFORMS];
+  int m_uniform_count = 0;
+  unsigned int m_id;
+
+  void SetValue(int uniform, const void *value, int size);
+  void Upload(const Uniform &uniform);
+};
+
+}; // namespace Rain
@@ -2,13 +2,40 @@
 #define PARTICLE_H
 
 #include <core.h>
+#include <vector>
 
-struct Particle {
-  Vector2 position;
-  Vector2 velocity;
-  float rotation;
-  Color color;
-  Vector2 size;
+// Particle state stored as structure-of-arrays so the integrate pass can
+// stream each component through SIMD registers. Per-system constants such as
+// color, size and rotation live in ParticleSystemOptions instead.
+struct ParticleBuffer {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> vx;
+  std::vector<float> vy;
+
+  size_t size() const { return x.size(); }
+
+  void reserve(size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    vx.reserve(capacity);
+    vy.reserve(capacity);
+  }
+
+  // Keeps the capacity, so shrinking and growing back does not reallocate
+  void truncate(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    vx.resize(count);
+    vy.resize(count);
+  }
+
+  void push_back(Vector2 position, Vector2 velocity) {
+    x.push_back(position.x);
+    y.push_back(position.y);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+  }
 };
 
 #endif
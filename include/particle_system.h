@@ -2,13 +2,26 @@
 
 #include <core.h>
 #include <entity.h>
+#include <job_system.h>
+#include <material.h>
 #include <particle.h>
+#include <platform.h>
 #include <stdlib.h>
 #include <vector>
+#include <water_surface.h>
 
 namespace Rain {
 
+enum class ParticleSystemMode {
+  // Particles are integrated on the CPU and uploaded every frame
+  Simulated,
+  // Particle positions are derived on the GPU from (instance id, seed, time)
+  Analytic,
+};
+
 struct ParticleSystemOptions {
+  Platform *platform;
+  JobSystem *jobs;
   Shader shader;
   int min_particles;
   int max_particles;
@@ -17,26 +30,84 @@ struct ParticleSystemOptions {
   float start_rotation;
   float spawn_rate;
   Color color;
+  ParticleSystemMode mode = ParticleSystemMode::Simulated;
 };
 
 class ParticleSystem : public Entity {
 public:
+  // Particles integrated by one job, a multiple of every SIMD width
+  const static size_t UPDATE_CHUNK_SIZE = 16384;
+  // Cells along each side of the grid that records where simulated particles
+  // are for GetDrawRects
+  const static int DAMAGE_GRID_SIZE = 64;
+
   ParticleSystem();
   ParticleSystem(ParticleSystemOptions options);
 
   void Init();
   void OnDraw();
   void OnUpdate(float dt);
+  void Unload();
+
+  // Caps the live particles below max_particles, dropping the excess right
+  // away. Buffers stay sized for max_particles.
+  void SetActiveLimit(size_t limit);
+
+  // Simulated particles that reach the surface push it down and respawn
+  // instead of falling through to the bottom. Not owned.
+  void SetWaterSurface(WaterSurface *surface) { m_water = surface; }
+
+  // Screen rectangle the next OnDraw covers, empty without particles
+  Rectangle GetDrawBounds();
+  // Appends screen rectangles covering every particle the next OnDraw draws,
+  // a run of grid cells each at most. Analytic particles are only placed on
+  // the GPU, so they append the draw bounds instead.
+  void GetDrawRects(std::vector<Rectangle> &rects);
 
 private:
   ParticleSystemOptions m_options;
-  std::vector<Particle> m_particles;
+  ParticleBuffer m_particles;
+  size_t m_active_limit = 0;
+  WaterSurface *m_water = nullptr;
+  size_t m_analytic_count = 0;
+  int m_seed = 0;
+  uint32_t m_cycle_base = 0;
+  double m_cycle_fraction = 0;
+  float m_last_dt = 0;
+  // Grid cells holding a particle after the last update, rows from the top.
+  // Every update job marks its own copy, merged once the jobs are done.
+  std::vector<uint8_t> m_damage_cells;
+  std::vector<uint8_t> m_chunk_damage_cells;
+
+  Material m_material;
+  unsigned int m_vao = 0;
+  unsigned int m_quad_vbo = 0;
+  unsigned int m_instance_vbo = 0;
+  int m_mvp_uniform = -1;
+  int m_offset_uniform = -1;
+  int m_area_uniform = -1;
+  int m_cycle_base_uniform = -1;
+  int m_cycle_fraction_uniform = -1;
+
+  bool IsAnalytic() { return m_options.mode == ParticleSystemMode::Analytic; }
+  size_t ParticleCount();
+
+  void LoadRenderData();
+  void LoadMaterial();
+  void UploadInstances();
+  Vector2 GetQuadExtent();
+  Vector2 GetDamageCellSize();
+  void MarkDamageCells(size_t begin, size_t end, uint8_t *cells);
+  void SetAnalyticUniforms();
+  void AdvanceAnalyticClock(float dt);
 
-  Particle CreateParticle();
   void UpdateParticles(float dt);
+  void UpdateParticleRange(float dt, size_t begin, size_t end,
+                           uint8_t *damage_cells);
   bool CanSpawnParticle();
   void SpawnParticle();
-  void ResetParticle(Particle &particle);
+  void ResetParticle(size_t index);
+  void CollideParticle(size_t index);
 };
 
 }; // namespace Rain
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <core.h>
+
+namespace Rain {
+
+// Source of time, screen size and input for the world. The windowed
+// application forwards to raylib, the headless one scripts everything so the
+// simulation can run without a display.
+class Platform {
+public:
+  virtual ~Platform() = default;
+
+  virtual bool IsHeadless() = 0;
+  virtual void NextFrame() = 0;
+  virtual float GetFrameTime() = 0;
+  virtual int GetScreenWidth() = 0;
+  virtual int GetScreenHeight() = 0;
+  virtual Vector2 GetMousePosition() = 0;
+  virtual bool IsKeyPressed(int key) = 0;
+  virtual bool IsMinimized() = 0;
+  virtual bool IsHidden() = 0;
+  virtual bool IsFocused() = 0;
+  // Whether the user moved the mouse or pressed a key or button this frame
+  virtual bool HasInput() = 0;
+};
+
+class RaylibPlatform : public Platform {
+public:
+  bool IsHeadless() { return false; }
+  void NextFrame() {}
+  float GetFrameTime() { return ::GetFrameTime(); }
+  int GetScreenWidth() { return ::GetScreenWidth(); }
+  int GetScreenHeight() { return ::GetScreenHeight(); }
+  Vector2 GetMousePosition() { return ::GetMousePosition(); }
+  bool IsKeyPressed(int key) { return ::IsKeyPressed(key); }
+  bool IsMinimized() { return IsWindowMinimized(); }
+  bool IsHidden() { return IsWindowHidden(); }
+  bool IsFocused() { return IsWindowFocused(); }
+  bool HasInput();
+};
+
+struct HeadlessPlatformOptions {
+  int screen_width = 1920;
+  int screen_height = 1080;
+  float frame_time = 1.0f / 144;
+  int duck_spawn_interval = 144;
+};
+
+class HeadlessPlatform : public Platform {
+public:
+  HeadlessPlatform(const HeadlessPlatformOptions &options);
+
+  bool IsHeadless() { return true; }
+  void NextFrame();
+  float GetFrameTime() { return m_options.frame_time; }
+  int GetScreenWidth() { return m_options.screen_width; }
+  int GetScreenHeight() { return m_options.screen_height; }
+  Vector2 GetMousePosition() { return m_mouse_position; }
+  bool IsKeyPressed(int key);
+  bool IsMinimized() { return false; }
+  bool IsHidden() { return false; }
+  bool IsFocused() { return true; }
+  bool HasInput() { return true; }
+
+private:
+  HeadlessPlatformOptions m_options;
+  long m_frame = 0;
+  Vector2 m_mouse_position = {0, 0};
+};
+
+}; // namespace Rain
@@ -2,8 +2,10 @@
 
 #include <core.h>
 #include <entity.h>
+#include <material.h>
 #include <math.h>
 #include <particle.h>
+#include <platform.h>
 
 #include <stdlib.h>
 #include <vector>
@@ -11,6 +13,7 @@
 namespace Rain {
 
 struct PoolOptions {
+  Platform *platform;
   float height_growth_rate;
   Shader shader;
   Texture texture;
@@ -33,14 +36,15 @@ public:
   void SetFoamColor(Color color);
   void SetFoamWidth(float width);
 
-  void BindShaderValue(const char *name, void *value, int uniformType);
-
-  std::vector<float> normalized_foam_color();
-  std::vector<float> normalized_water_color();
-
 private:
+  Platform *m_platform;
   float m_height_growth_rate;
   Shader m_shader;
+  Material m_material;
+  int m_time_uniform = -1;
+  int m_water_color_uniform = -1;
+  int m_foam_color_uniform = -1;
+  int m_foam_width_uniform = -1;
   Texture m_texture;
   Color m_foam_color;
   Color m_water_color;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Scoped timing zones. Building without RAIN_ENABLE_PROFILER turns every
+// zone into nothing, the Profiler itself then simply has no events.
+#if defined(RAIN_ENABLE_PROFILER)
+#define RAIN_PROFILE_CONCAT_INNER(a, b) a##b
+#define RAIN_PROFILE_CONCAT(a, b) RAIN_PROFILE_CONCAT_INNER(a, b)
+#define RAIN_PROFILE_ZONE(name)                                                \
+  Rain::ProfileZone RAIN_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#define RAIN_PROFILE_ZONE(name) ((void)0)
+#endif
+
+namespace Rain {
+
+// One timed span, in nanoseconds since the profiler started. Names must be
+// string literals, only the pointer is recorded.
+struct ProfileEvent {
+  const char *name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+struct ZoneSummary {
+  std::string_view name;
+  size_t count;
+  double mean_ms;
+  double p99_ms;
+};
+
+// Collects zones from every thread. Each thread records into its own
+// single-producer ring without locks; the main thread drains the rings once
+// per frame into rolling per-zone statistics and a bounded trace that can be
+// written in the Chrome trace event format.
+class Profiler {
+public:
+  const static size_t RING_CAPACITY = 1 << 14;
+  const static size_t ZONE_WINDOW = 256;
+  const static size_t MAX_TRACE_EVENTS = 1 << 20;
+
+  static Profiler &Get();
+
+  uint64_t Now() const;
+
+  // Called by the recording thread only. Events are dropped while its ring is
+  // full.
+  void Record(const ProfileEvent &event);
+  // Records an event on a named track instead of the calling thread, e.g.
+  // GPU timings. Only called from the main thread.
+  void RecordTrack(const char *track, const ProfileEvent &event);
+
+  // Drains every thread's ring, called once per frame by the main thread
+  void Collect();
+
+  std::vector<ZoneSummary> Summaries() const;
+  bool WriteChromeTrace(const std::string &path);
+
+private:
+  struct Ring {
+    ProfileEvent events[RING_CAPACITY];
+    // head is only written by the owning thread, tail by the collector
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    int track;
+  };
+
+  struct ZoneStats {
+    double samples_ms[ZONE_WINDOW];
+    size_t count = 0;
+    size_t next = 0;
+
+    void Add(double ms);
+  };
+
+  struct TraceEvent {
+    ProfileEvent event;
+    int track;
+  };
+
+  Profiler();
+
+  uint64_t m_epoch_ns;
+
+  std::mutex m_rings_mutex;
+  std::vector<std::unique_ptr<Ring>> m_rings;
+  std::vector<std::string> m_track_names;
+
+  std::unordered_map<std::string_view, ZoneStats> m_zones;
+  std::vector<TraceEvent> m_trace;
+  size_t m_trace_next = 0;
+
+  Ring &ThreadRing();
+  int RegisterTrack(const std::string &name);
+  void AddCollected(const ProfileEvent &event, int track);
+};
+
+class ProfileZone {
+public:
+  ProfileZone(const char *name)
+      : m_name(name), m_start_ns(Profiler::Get().Now()) {}
+  ~ProfileZone() {
+    Profiler::Get().Record({m_name, m_start_ns, Profiler::Get().Now()});
+  }
+
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+
+private:
+  const char *m_name;
+  uint64_t m_start_ns;
+};
+
+}; // namespace Rain
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Rain {
+
+struct QualityGovernorOptions {
+  // Frame time the application may use, 0 disables the governor
+  float budget_ms;
+  // Quality drops while frames average above budget_ms * high_ratio and rises
+  // while they average below budget_ms * low_ratio. The gap between the two
+  // keeps it from oscillating around the budget.
+  float high_ratio = 0.95f;
+  float low_ratio = 0.7f;
+  // Frames averaged for every decision
+  int window = 60;
+  float step = 0.1f;
+  float min_level = 0.25f;
+};
+
+// Turns measured frame times into a quality level in [min_level, 1]. The
+// level moves by at most one step per window, so changes stay gradual.
+class QualityGovernor {
+public:
+  QualityGovernor(const QualityGovernorOptions &options);
+
+  bool IsEnabled() const { return m_options.budget_ms > 0; }
+
+  // Returns true when the level changed
+  bool AddFrame(double frame_ms);
+
+  float level() const { return m_level; }
+
+private:
+  QualityGovernorOptions m_options;
+  float m_level = 1.0f;
+  double m_window_sum_ms = 0;
+  int m_window_frames = 0;
+};
+
+}; // namespace Rain
@@ -4,6 +4,7 @@
 #include <array>
 #include <earcut.hpp>
 #include <iostream>
+#include <profiler.h>
 #include <raylib.h>
 #include <rlgl.h>
 #include <vector>
@@ -40,18 +41,263 @@ static void DrawTexturePoly(Texture2D texture, Vector2 center, Vector2 *points,
   rlSetTexture(0);
 }
 
-static void DrawPolygon(Texture2D texture, Vector2 center, Vector2 *points,
-                        Vector2 *texcoords, int pointCount, Color tint) {
+// Buffers reused across triangulations, so the fast paths do not allocate
+// once they have grown to the largest polygon seen.
+struct TriangulationScratch {
+  std::vector<N> indices;
+  std::vector<N> order;
+  std::vector<int> chains;
+  std::vector<N> stack;
   std::vector<std::vector<Point>> polygon;
-  std::vector<Point> outer;
+  mapbox::detail::Earcut<N> earcut;
+};
+
+static float Cross(Vector2 a, Vector2 b, Vector2 c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+static bool LexLess(Vector2 a, Vector2 b) {
+  return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+// Emits a triangle wound like rlgl's own quads (clockwise in screen space),
+// which survives back-face culling.
+static void PushTriangle(std::vector<N> &indices, Vector2 *points, N a, N b,
+                         N c) {
+  if (Cross(points[a], points[b], points[c]) > 0) {
+    std::swap(b, c);
+  }
+
+  indices.push_back(a);
+  indices.push_back(b);
+  indices.push_back(c);
+}
+
+static float SignedArea(Vector2 *points, int pointCount) {
+  float area = 0;
+
+  for (int i = 0, j = pointCount - 1; i < pointCount; j = i++) {
+    area += (points[j].x - points[i].x) * (points[j].y + points[i].y);
+  }
+
+  return area;
+}
+
+// Convex when every turn has the same direction and the edges sweep around
+// only once, which rules out self-intersecting stars.
+static bool IsConvex(Vector2 *points, int pointCount) {
+  int sign = 0;
+  int x_flips = 0;
+  float previous_dx = 0;
+
+  for (int i = 0; i < pointCount; i++) {
+    Vector2 a = points[i];
+    Vector2 b = points[(i + 1) % pointCount];
+    Vector2 c = points[(i + 2) % pointCount];
+    float cross = Cross(a, b, c);
+    float dx = b.x - a.x;
+
+    if (cross != 0) {
+      int turn = cross > 0 ? 1 : -1;
+
+      if (sign != 0 && turn != sign) {
+        return false;
+      }
+
+      sign = turn;
+    }
+
+    if (dx != 0) {
+      if (previous_dx != 0 && (dx > 0) != (previous_dx > 0)) {
+        x_flips++;
+      }
+
+      previous_dx = dx;
+    }
+  }
+
+  return x_flips <= 2;
+}
+
+static void TriangulateConvex(Vector2 *points, int pointCount,
+                              std::vector<N> &indices) {
+  for (int i = 1; i < pointCount - 1; i++) {
+    PushTriangle(indices, points, 0, i, i + 1);
+  }
+}
+
+// Linear-time triangulation of a polygon that is monotone in x (ties broken
+// by y), such as a height field closed along its bottom.
+// Returns false if the polygon is not x-monotone, or its two chains touch or
+// cross, which the sweep cannot triangulate.
+static bool TriangulateMonotone(Vector2 *points, int pointCount,
+                                TriangulationScratch &scratch) {
+  int min_i = 0, max_i = 0;
+
+  for (int i = 1; i < pointCount; i++) {
+    if (LexLess(points[i], points[min_i])) {
+      min_i = i;
+    }
+
+    if (LexLess(points[max_i], points[i])) {
+      max_i = i;
+    }
+  }
+
+  // Merge the forward chain (min to max by increasing index) and the
+  // backward chain into one sequence sorted by x
+  scratch.order.clear();
+  scratch.chains.clear();
+
+  int forward = (min_i + 1) % pointCount;
+  int backward = (min_i + pointCount - 1) % pointCount;
+  int last_forward = min_i, last_backward = min_i;
+  // Side every vertex has to be on of the other chain's edge spanning its x,
+  // taken from the first one. Both chains meet only at min and max, so any
+  // crossing puts some vertex on the wrong side.
+  int side = 0;
+
+  scratch.order.push_back(min_i);
+  scratch.chains.push_back(0);
+
+  while (forward != max_i || backward != max_i) {
+    bool take_forward =
+        backward == max_i ||
+        (forward != max_i && LexLess(points[forward], points[backward]));
+
+    float cross =
+        take_forward
+            ? Cross(points[last_backward], points[backward], points[forward])
+            : -Cross(points[last_forward], points[forward], points[backward]);
+
+    if (cross == 0 || (side != 0 && (cross > 0 ? 1 : -1) != side)) {
+      return false;
+    }
+
+    side = cross > 0 ? 1 : -1;
+
+    if (take_forward) {
+      if (LexLess(points[forward], points[last_forward])) {
+        return false;
+      }
+
+      scratch.order.push_back(forward);
+      scratch.chains.push_back(1);
+      last_forward = forward;
+      forward = (forward + 1) % pointCount;
+    } else {
+      if (LexLess(points[backward], points[last_backward])) {
+        return false;
+      }
+
+      scratch.order.push_back(backward);
+      scratch.chains.push_back(-1);
+      last_backward = backward;
+      backward = (backward + pointCount - 1) % pointCount;
+    }
+  }
+
+  scratch.order.push_back(max_i);
+  scratch.chains.push_back(0);
+
+  float orientation = SignedArea(points, pointCount) > 0 ? 1 : -1;
+  std::vector<N> &order = scratch.order;
+  std::vector<int> &chains = scratch.chains;
+  std::vector<N> &stack = scratch.stack;
+  int count = order.size();
+
+  stack.clear();
+  stack.push_back(0);
+  stack.push_back(1);
+
+  for (int j = 2; j < count - 1; j++) {
+    if (chains[j] != chains[stack.back()]) {
+      for (size_t k = 0; k + 1 < stack.size(); k++) {
+        PushTriangle(scratch.indices, points, order[j], order[stack[k]],
+                     order[stack[k + 1]]);
+      }
+
+      stack.clear();
+      stack.push_back(j - 1);
+      stack.push_back(j);
+    } else {
+      N last = stack.back();
+
+      stack.pop_back();
+
+      while (!stack.empty()) {
+        N top = stack.back();
+        float turn = Cross(points[order[top]], points[order[last]],
+                           points[order[j]]) *
+                     orientation * chains[j];
+
+        // The diagonal to top is inside only if the turn at last is convex
+        if (turn <= 0) {
+          break;
+        }
+
+        PushTriangle(scratch.indices, points, order[j], order[last],
+                     order[top]);
+        last = top;
+        stack.pop_back();
+      }
+
+      stack.push_back(last);
+      stack.push_back(j);
+    }
+  }
+
+  for (size_t k = 0; k + 1 < stack.size(); k++) {
+    PushTriangle(scratch.indices, points, order[count - 1], order[stack[k]],
+                 order[stack[k + 1]]);
+  }
+
+  return true;
+}
+
+static void TriangulateEarcut(Vector2 *points, int pointCount,
+                              TriangulationScratch &scratch) {
+  scratch.polygon.resize(1);
+
+  std::vector<Point> &outer = scratch.polygon[0];
+
+  outer.clear();
 
   for (int i = 0; i < pointCount; i++) {
     outer.push_back({points[i].x, points[i].y});
   }
 
-  polygon.push_back(outer);
+  scratch.earcut(scratch.polygon);
+  scratch.indices.assign(scratch.earcut.indices.rbegin(),
+                         scratch.earcut.indices.rend());
+}
+
+// Triangulates a simple polygon into scratch.indices. Convex and x-monotone
+// inputs take linear-time paths, anything else falls back to earcut.
+static const std::vector<N> &Triangulate(Vector2 *points, int pointCount,
+                                         TriangulationScratch &scratch) {
+  scratch.indices.clear();
+
+  if (pointCount < 3) {
+    return scratch.indices;
+  }
+
+  if (IsConvex(points, pointCount)) {
+    TriangulateConvex(points, pointCount, scratch.indices);
+  } else if (!TriangulateMonotone(points, pointCount, scratch)) {
+    scratch.indices.clear();
+    TriangulateEarcut(points, pointCount, scratch);
+  }
 
-  std::vector<N> indices = mapbox::earcut<N>(polygon);
+  return scratch.indices;
+}
+
+static void DrawPolygon(Texture2D texture, Vector2 center, Vector2 *points,
+                        Vector2 *texcoords, int pointCount, Color tint,
+                        TriangulationScratch &scratch) {
+  RAIN_PROFILE_ZONE("DrawPolygon");
+
+  const std::vector<N> &indices = Triangulate(points, pointCount, scratch);
 
   rlSetTexture(texture.id);
 
@@ -59,8 +305,6 @@ static void DrawPolygon(Texture2D texture, Vector2 center, Vector2 *points,
 
   rlColor4ub(tint.r, tint.g, tint.b, tint.a);
 
-  std::reverse(indices.begin(), indices.end());
-
   for (int i = 0; i < indices.size(); i += 3) {
     rlTexCoord2f(texcoords[indices[i]].x, texcoords[indices[i]].y);
     rlVertex2f(points[indices[i]].x + center.x,
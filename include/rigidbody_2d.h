@@ -2,33 +2,30 @@
 
 #include "entity.h"
 #include "raylib.h"
+#include "raymath.h"
 
-namespace Rain {
-class Rigidbody2d : public Entity {
-public:
-  Rigidbody2d(Entity *entity);
-
-  void Init();
-  void OnUpdate(float dt);
-  void OnDraw();
+#include <cstddef>
 
-  void AddForce(Vector2 force);
+namespace Rain {
 
-  void SetMass(float mass) { m_mass = mass; }
-  float mass() { return m_mass; }
+// Rigid-body state of one entity. Systems keep these by value in an array
+// parallel to their transforms, so integration is a linear sweep.
+struct Rigidbody2d {
+  Vector2 velocity = {0, 0};
+  Vector2 acceleration = {0, 0};
+  float mass = 1;
+  float inverse_mass = 1;
+};
 
-  void SetVelocity(Vector2 velocity) { m_velocity = velocity; }
-  Vector2 velocity() { return m_velocity; }
+Rigidbody2d CreateRigidbody2d(float mass);
 
-private:
-  Entity *m_parent;
+void AddForce(Rigidbody2d &body, Vector2 force);
+// Changes the velocity immediately, unlike a force integrated next update
+void ApplyImpulse(Rigidbody2d &body, Vector2 impulse);
 
-  Vector2 m_velocity = Vector2Zero();
-  Vector2 m_acceleration = Vector2Zero();
-  Vector2 m_center_of_mass = {0.5, 0.5};
+// Integrates the accumulated forces of bodies [begin, end) into their
+// velocities and transforms, then clears the forces.
+void IntegrateRigidbodies(Rigidbody2d *bodies, Transform *transforms,
+                          size_t begin, size_t end, float dt);
 
-  float m_mass;
-  float m_angular_velocity = 0;
-  float m_angular_acceleration = 0;
-};
-}; // namespace Rain
\ No newline at end of file
+}; // namespace Rain
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <core.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Rain {
+
+// Uniform grid over an unbounded plane, storing only the occupied cells.
+// Every object lives in the cell that contains its center, so as long as no
+// object is wider than a cell its overlaps are found in the 3x3 block of cells
+// around it. Objects are identified by dense ids, e.g. indices into an array.
+class SpatialHash {
+public:
+  // Cell coordinates are clamped to [-MAX_CELL, MAX_CELL], which leaves room
+  // for the neighbors of the outermost cells
+  const static int MAX_CELL = 1 << 30;
+
+  SpatialHash(float cell_size);
+
+  void Insert(int id, Vector2 center);
+  // Only touches the cells when the object crossed into another one
+  void Move(int id, Vector2 center);
+  void Clear();
+
+  // Appends the ids stored in the 3x3 cells around center, including the
+  // object at center itself
+  void QueryNeighbors(Vector2 center, std::vector<int> &ids) const;
+
+  float cell_size() const { return m_cell_size; }
+
+private:
+  struct Entry {
+    uint64_t cell;
+    // Position of the id inside its cell, for O(1) removal
+    size_t slot;
+  };
+
+  float m_cell_size;
+  std::unordered_map<uint64_t, std::vector<int>> m_cells;
+  std::vector<Entry> m_entries;
+
+  uint64_t CellKey(int cell_x, int cell_y) const;
+  uint64_t CellOf(Vector2 center) const;
+  int CellCoordinate(float position) const;
+  void Add(int id, uint64_t cell);
+  void Remove(int id);
+};
+
+}; // namespace Rain
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <core.h>
+#include <material.h>
+
+#include <vector>
+
+namespace Rain {
+
+// A textured quad to draw, with source in pixels of the batch texture.
+struct Sprite {
+  Rectangle source;
+  Color tint;
+};
+
+// Collects the sprite quads of a frame into one vertex buffer and draws them
+// with as few draw calls as the 16 bit index range allows. Every sprite must
+// come from the same texture, usually a TextureAtlas.
+class SpriteBatch {
+public:
+  // rlgl draws indexed meshes with 16 bit indices
+  const static int MAX_QUADS = 16384;
+
+  // Needs a GL context, it loads the buffers and uses raylib's default shader
+  SpriteBatch(Texture texture);
+  ~SpriteBatch();
+
+  SpriteBatch(const SpriteBatch &) = delete;
+  SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+  // Same placement rules as DrawTexturePro
+  void Add(Rectangle source, Rectangle dest, Vector2 origin, float rotation,
+           Color tint);
+  // Draws and clears the collected quads
+  void Flush();
+
+private:
+  struct SpriteVertex {
+    float x, y;
+    float u, v;
+    Color color;
+  };
+
+  Texture m_texture;
+  Material m_material;
+  int m_mvp_uniform = -1;
+  unsigned int m_vao = 0;
+  unsigned int m_vbo = 0;
+  unsigned int m_ebo = 0;
+  std::vector<SpriteVertex> m_vertices;
+
+  void DrawQuads(const SpriteVertex *vertices, int quad_count);
+};
+
+}; // namespace Rain
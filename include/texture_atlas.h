@@ -0,0 +1,37 @@
+#pragma once
+
+#include <core.h>
+
+#include <vector>
+
+namespace Rain {
+
+// Packs images into one texture at startup, so sprites from different images
+// can be drawn with a single texture bound. Images are placed on shelves in
+// order of decreasing height.
+class TextureAtlas {
+public:
+  // Transparent border around every image, keeps filtering from sampling the
+  // neighbors
+  const static int PADDING = 1;
+
+  // Takes ownership of the image and returns the id of its region
+  int Add(Image image);
+  int Add(const char *file_name);
+
+  // Packs every added image into rows at most width pixels wide and uploads
+  // the atlas texture. The images are unloaded afterwards.
+  void Build(int width = 1024);
+  void Unload();
+
+  // Pixel rectangle of an image inside the atlas texture
+  Rectangle region(int id) const { return m_regions[id]; }
+  Texture texture() const { return m_texture; }
+
+private:
+  std::vector<Image> m_images;
+  std::vector<Rectangle> m_regions;
+  Texture m_texture = {};
+};
+
+}; // namespace Rain
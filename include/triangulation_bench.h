@@ -0,0 +1,13 @@
+#pragma once
+
+namespace Rain {
+
+// Times Triangulate against a plain earcut call on water-like and convex
+// polygons and prints polygons per second for both.
+void RunTriangulationBenchmark(int iterations);
+
+// Triangulates random x-monotone polygons, simple or not, and checks every
+// result against earcut. Prints the first polygon that differs.
+bool RunTriangulationTest(int polygons);
+
+}; // namespace Rain
@@ -1,11 +1,27 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <raylib.h>
+#include <thread>
 #include <vector>
 
 namespace Rain {
-static std::vector<float> NormalizeColor(Color color) {
-  return {color.r / 255.0f, color.g / 255.0f, color.b / 255.0f,
-          color.a / 255.0f};
+// State of ThreadRandom, one per thread across the whole program
+inline thread_local uint32_t s_thread_random_state =
+    (0x9e3779b9u ^
+     (uint32_t)std::hash<std::thread::id>{}(std::this_thread::get_id())) |
+    1u;
+
+// Per-thread xorshift generator in [0, 1]. Unlike RANDOM() it is safe to call
+// from job workers.
+inline float ThreadRandom() {
+  uint32_t &state = s_thread_random_state;
+
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+
+  return (state >> 8) / 16777215.0f;
 }
 }; // namespace Rain
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Rain {
+
+// Snapshot of the water surface that other systems read while the pool
+// updates, plus the impulses they add to it. Heights are screen y values at
+// evenly spaced columns. Every job thread adds impulses to its own row, and
+// Sync folds the rows into impulses() for the pool to apply on its next step.
+class WaterSurface {
+public:
+  WaterSurface(int thread_count = 1);
+
+  // Folds the pending impulses and replaces the heights with count columns
+  // starting at min_x. Impulses are dropped when the column count changed.
+  // Must not run while other threads read the surface or add impulses.
+  void Sync(float min_x, float column_width, const float *ys, size_t count);
+
+  // Height of the surface at x, +INFINITY where there is no water
+  float HeightAt(float x) const;
+  // Topmost height of all columns, nothing above it can touch the water
+  float min_y() const { return m_min_y; }
+
+  // Pushes the column closest to x down by impulse, in units of velocity
+  void AddImpulse(float x, float impulse);
+
+  // Impulse per column gathered by the last Sync
+  const std::vector<float> &impulses() const { return m_impulses; }
+
+private:
+  int m_thread_count;
+  float m_min_x = 0;
+  float m_column_width = 1;
+  float m_min_y;
+  std::vector<float> m_ys;
+  std::vector<float> m_impulses;
+  // One row per thread, padded to whole cache lines so threads never share
+  // one
+  std::vector<float> m_thread_impulses;
+  size_t m_row_stride = 0;
+};
+
+}; // namespace Rain
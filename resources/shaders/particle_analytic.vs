@@ -0,0 +1,55 @@
+#version 330
+
+in vec2 vertexPosition;
+
+uniform mat4 mvp;
+uniform vec2 size;
+uniform vec2 rotation;
+uniform vec4 color;
+
+uniform vec2 area;
+uniform vec2 velocity;
+uniform int seed;
+uniform int cycleBase;
+uniform float cycleFraction;
+
+out vec4 fragColor;
+
+uint hash(uint x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+
+  return x;
+}
+
+float random01(uint x) { return float(hash(x) >> 8) / 16777216.0; }
+
+void main() {
+  uint id;
+  float cycles;
+  uint cycle;
+  float period;
+  vec2 drop;
+  vec2 corner;
+  vec2 rotated;
+
+  // Every drop falls from y = 0 to area.y and then respawns at a new random
+  // x. Its progress through the current fall is offset by a per-drop phase.
+  id = hash(uint(gl_InstanceID) ^ uint(seed));
+  period = area.y / velocity.y;
+  cycles = cycleFraction + random01(id);
+  cycle = uint(cycleBase) + uint(floor(cycles));
+
+  drop = vec2(random01(id ^ hash(cycle)) * area.x, 0.0) +
+         velocity * fract(cycles) * period;
+
+  corner = vertexPosition * size;
+  rotated = vec2(corner.x * rotation.x - corner.y * rotation.y,
+                 corner.x * rotation.y + corner.y * rotation.x);
+
+  fragColor = color;
+  gl_Position = mvp * vec4(drop + rotated, 0.0, 1.0);
+}
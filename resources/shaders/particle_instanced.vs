@@ -0,0 +1,26 @@
+#version 330
+
+in vec2 vertexPosition;
+in float instanceX;
+in float instanceY;
+
+uniform mat4 mvp;
+uniform vec2 size;
+uniform vec2 rotation;
+uniform vec4 color;
+uniform vec2 offset;
+
+out vec4 fragColor;
+
+void main() {
+  vec2 corner;
+  vec2 rotated;
+
+  corner = vertexPosition * size;
+  rotated = vec2(corner.x * rotation.x - corner.y * rotation.y,
+                 corner.x * rotation.y + corner.y * rotation.x);
+
+  fragColor = color;
+  gl_Position =
+      mvp * vec4(vec2(instanceX, instanceY) + offset + rotated, 0.0, 1.0);
+}
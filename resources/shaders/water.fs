@@ -1,12 +1,14 @@
-#version 120
+#version 330
 
-varying vec2 fragTexCoord;
-varying vec4 fragColor;
+in vec2 fragTexCoord;
+in vec4 fragColor;
 
 uniform vec4 foamColor;
 uniform vec4 waterColor;
 uniform float foamWidth;
 
+out vec4 finalColor;
+
 void main() {
-  gl_FragColor = waterColor;
+  finalColor = waterColor;
 }
@@ -0,0 +1,34 @@
+#version 330
+
+in float vertexX;
+in float vertexY;
+in vec2 vertexTexCoord;
+
+uniform mat4 mvp;
+
+// With the GPU simulation the top vertices take their height from the state
+// rows of the last two steps instead of vertexY
+uniform int gpuHeights;
+uniform sampler2D heights;
+uniform sampler2D previousHeights;
+uniform float renderAlpha;
+uniform float centerY;
+uniform int meshCapacity;
+
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main() {
+  float y = vertexY;
+
+  if (gpuHeights != 0 && gl_VertexID < meshCapacity) {
+    ivec2 texel = ivec2(gl_VertexID, 0);
+
+    y = centerY + mix(texelFetch(previousHeights, texel, 0).z,
+                      texelFetch(heights, texel, 0).z, renderAlpha);
+  }
+
+  fragTexCoord = vertexTexCoord;
+  fragColor = vec4(1.0);
+  gl_Position = mvp * vec4(vertexX, y, 0.0, 1.0);
+}
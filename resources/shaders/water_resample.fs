@@ -0,0 +1,24 @@
+#version 330
+
+// Linearly resamples a row of sourceCount texels onto the target width, with
+// both end texels kept in place.
+
+uniform sampler2D texture0;
+
+uniform int sourceCount;
+uniform int targetCount;
+
+out vec4 finalColor;
+
+void main() {
+  int i = int(gl_FragCoord.x);
+  float source =
+      targetCount > 1 ? float(i * (sourceCount - 1)) / float(targetCount - 1)
+                      : 0.0;
+  int left = min(int(source), sourceCount - 1);
+  int right = min(left + 1, sourceCount - 1);
+
+  finalColor = mix(texelFetch(texture0, ivec2(left, 0), 0),
+                   texelFetch(texture0, ivec2(right, 0), 0),
+                   source - float(left));
+}
@@ -0,0 +1,31 @@
+#version 330
+
+// Adds the push of one interactor to the impulse row, drawn as a quad over
+// the columns in its radius with additive blending.
+
+uniform sampler2D state;
+
+uniform vec2 center;
+uniform float firstX;
+uniform float columnWidth;
+uniform float rest;
+uniform vec2 interactor;
+uniform float radius;
+uniform float strength;
+uniform float maxInfluence;
+
+out vec4 finalColor;
+
+void main() {
+  int i = int(gl_FragCoord.x);
+  vec4 point = texelFetch(state, ivec2(i, 0), 0);
+  vec2 position = center + vec2(firstX + columnWidth * float(i), point.z);
+  float dist = distance(position, interactor);
+  float impulse = 0.0;
+
+  if (abs(rest - point.x) <= maxInfluence && dist > 0.0 && dist <= radius) {
+    impulse = (radius - dist) / radius * strength;
+  }
+
+  finalColor = vec4(impulse, 0.0, 0.0, 0.0);
+}
@@ -0,0 +1,47 @@
+#version 330
+
+// One step of the spring chain, one fragment per wave point. State texels
+// hold (offset, velocity, offset + background waves, 1). Every point reads
+// its neighbors from the previous step only, so the result does not depend
+// on the order points are processed in.
+
+uniform sampler2D texture0;
+uniform sampler2D impulses;
+
+uniform int count;
+uniform float dt;
+uniform float springConstant;
+uniform float baselineConstant;
+uniform float damping;
+uniform float rest;
+uniform float firstX;
+uniform float columnWidth;
+uniform vec4 waveAmplitudes;
+uniform vec4 waveNumbers;
+uniform vec4 wavePhases;
+
+out vec4 finalColor;
+
+void main() {
+  int i = int(gl_FragCoord.x);
+  vec4 state = texelFetch(texture0, ivec2(i, 0), 0);
+  // A missing neighbor pulls with no force, like the ends of the CPU chain
+  float left = i > 0 ? texelFetch(texture0, ivec2(i - 1, 0), 0).x : state.x;
+  float right =
+      i < count - 1 ? texelFetch(texture0, ivec2(i + 1, 0), 0).x : state.x;
+  float velocity = state.y + texelFetch(impulses, ivec2(i, 0), 0).x;
+  float force = baselineConstant * (rest - state.x) +
+                springConstant * (left + right - 2.0 * state.x);
+  float offset;
+  float x;
+  vec4 waves;
+
+  // Semi-implicit Euler: the new velocity moves the point
+  velocity = (velocity + force * dt) * damping;
+  offset = state.x + velocity * dt;
+
+  x = firstX + columnWidth * float(i);
+  waves = waveAmplitudes * sin(waveNumbers * x + wavePhases) + waveAmplitudes;
+
+  finalColor = vec4(offset, velocity, offset + dot(waves, vec4(1.0)), 1.0);
+}
@@ -2,18 +2,48 @@
 #include "interactive_pool.h"
 #include "raylib.h"
 #include "raymath.h"
-#include "rigidbody_2d.h"
+
+#include <algorithm>
+#include <chrono>
 
 namespace Rain {
 
-Application::Application(int quit_timeout, int min_particles, int max_particles)
-    : m_quit_timeout(quit_timeout), m_min_particles(min_particles),
-      m_max_particles(max_particles) {}
+Application::Application(const ApplicationOptions &options)
+    : m_quit_timeout(options.quit_timeout),
+      m_min_particles(options.min_particles),
+      m_max_particles(options.max_particles), m_rain_mode(options.rain_mode),
+      m_wave_solver(options.wave_solver),
+      m_adaptive_water(options.adaptive_water),
+      m_water_resolution(options.water_resolution),
+      m_headless(options.headless),
+      m_headless_options(options.headless_options),
+      m_simulation_rate(options.simulation_rate),
+      m_step_rate(options.simulation_rate),
+      m_max_simulation_steps(options.max_simulation_steps),
+      m_worker_threads(options.worker_threads),
+      m_trace_path(options.trace_path),
+      m_profiler_overlay(options.profiler_overlay),
+      m_governor(QualityGovernorOptions{.budget_ms = options.frame_budget_ms}),
+      m_max_damage_percent(options.max_damage_percent) {}
 
 Application::~Application() {}
 
 void Application::Init() {
-  SetupWindow();
+  if (m_worker_threads < 0) {
+    m_worker_threads =
+        std::max(0, (int)std::thread::hardware_concurrency() - 1);
+  }
+
+  m_jobs = std::make_unique<JobSystem>(m_worker_threads);
+
+  if (m_headless) {
+    m_platform = std::make_unique<HeadlessPlatform>(m_headless_options);
+  } else {
+    m_platform = std::make_unique<RaylibPlatform>();
+
+    SetupWindow();
+  }
+
   SetupWorld();
 }
 
@@ -22,15 +52,53 @@ void Application::SetupWindow() {
                  FLAG_BORDERLESS_WINDOWED_MODE);
   InitWindow(GetScreenWidth(), GetScreenHeight(), "Rain");
   SetWindowState(FLAG_WINDOW_UNDECORATED);
-  SetTargetFPS(144);
+  SetTargetFPS(m_scheduler.target_fps());
+
+#if defined(RAIN_ENABLE_PROFILER)
+  m_gpu_timer = std::make_unique<GpuTimer>();
+
+  if (!m_gpu_timer->IsSupported()) {
+    m_gpu_timer.reset();
+  }
+#endif
 }
 
 void Application::SetupWorld() {
-  m_rain_shader = LoadShader(0, "resources/shaders/particle.fs");
-  m_pool_shader = LoadShader(0, "resources/shaders/water.fs");
-  m_default_texture = LoadTexture("resources/textures/default.png");
-  m_duck_texture = LoadTexture("resources/textures/duck.png");
-  m_foreground = LoadRenderTexture(GetScreenWidth(), GetScreenHeight());
+  // Without a window there is no GL context, so GPU resources stay zeroed
+  if (m_headless) {
+    m_rain_shader = Shader{};
+    m_pool_shader = Shader{};
+    m_water_shader = Shader{};
+    m_default_texture = Texture{};
+    m_foreground = RenderTexture{};
+    // Tracked without a target, for the damage the frame stats report
+    m_foreground_damage = DamageTracker(
+        Rectangle{0, 0, (float)m_platform->GetScreenWidth(),
+                  (float)m_platform->GetScreenHeight()});
+  } else {
+    if (m_rain_mode == ParticleSystemMode::Analytic) {
+      m_rain_shader = LoadShader("resources/shaders/particle_analytic.vs",
+                                 "resources/shaders/particle_instanced.fs");
+    } else {
+      m_rain_shader = LoadShader("resources/shaders/particle_instanced.vs",
+                                 "resources/shaders/particle_instanced.fs");
+    }
+
+    m_pool_shader = LoadShader(0, "resources/shaders/water.fs");
+    m_water_shader = LoadShader("resources/shaders/water.vs",
+                                "resources/shaders/water.fs");
+    m_default_texture = LoadTexture("resources/textures/default.png");
+    m_duck_region = m_atlas.Add("resources/textures/duck.png");
+    m_atlas.Build();
+    m_sprite_batch = std::make_unique<SpriteBatch>(m_atlas.texture());
+    m_foreground = LoadRenderTexture(m_platform->GetScreenWidth(),
+                                     m_platform->GetScreenHeight());
+    // Upscales the foreground when the governor lowers the render scale
+    SetTextureFilter(m_foreground.texture, TEXTURE_FILTER_BILINEAR);
+    m_foreground_damage = DamageTracker(
+        Rectangle{0, 0, (float)m_foreground.texture.width,
+                  (float)m_foreground.texture.height});
+  }
 
   this->m_rain =
       std::unique_ptr<ParticleSystem>(CreateRainParticleSystem(m_rain_shader));
@@ -39,122 +107,467 @@ void Application::SetupWorld() {
       std::unique_ptr<Pool>(CreatePool(m_pool_shader, m_default_texture));
 
   this->m_interactive_pool = std::unique_ptr<InteractivePool>(
-      CreateInteractivePool(m_pool_shader, m_default_texture));
+      CreateInteractivePool(m_water_shader, m_default_texture));
+
+  this->m_ducks = std::unique_ptr<DuckSystem>(CreateDuckSystem());
 
-  this->m_duck = std::unique_ptr<Duck>(CreateDuck(m_duck_texture));
+  this->m_rain->SetWaterSurface(&m_interactive_pool->surface());
 
   this->m_rain->Init();
   this->m_pool->Init();
   this->m_interactive_pool->Init();
-  this->m_duck->Init();
 }
 
 void Application::Run() {
+  if (m_headless) {
+    RunHeadless();
+  } else {
+    RunWindowed();
+  }
+
+  Teardown();
+}
+
+void Application::RunWindowed() {
   while (!m_should_close && !WindowShouldClose()) {
+    if (m_scheduler.Update(*m_platform, m_platform->GetFrameTime())) {
+      ApplyFrameState();
+    }
+
+    // An idle frame only keeps the timeout running and polls events, which
+    // EndDrawing does at the idle frame rate
+    if (m_scheduler.state() == FrameState::Idle) {
+      Update();
+      BeginDrawing();
+      EndDrawing();
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
     Update();
     Draw();
+
+    // Measured before EndDrawing, which waits for the target frame rate
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    EndDrawing();
+    Profiler::Get().Collect();
+    UpdateQuality(elapsed.count());
   }
+}
 
-  Teardown();
+void Application::ApplyFrameState() {
+  FrameState state = m_scheduler.state();
+
+  SetTargetFPS(m_scheduler.target_fps());
+
+  m_simulation_paused = state == FrameState::Idle;
+  m_step_rate = m_scheduler.SimulationRate(m_simulation_rate);
+}
+
+void Application::RunHeadless() {
+  while (!m_should_close) {
+    auto start = std::chrono::steady_clock::now();
+
+    Update();
+    Profiler::Get().Collect();
+    TrackForegroundDamage();
+
+    double damaged_area = 0;
+
+    for (const Rectangle &rect : m_foreground_damage.damage()) {
+      damaged_area += rect.width * rect.height;
+    }
+
+    m_damage_percent_sum += 100 * damaged_area /
+                            (m_platform->GetScreenWidth() *
+                             m_platform->GetScreenHeight());
+    m_foreground_damage.EndFrame();
+
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    m_update_stats.Add(elapsed.count());
+    UpdateQuality(elapsed.count());
+    m_platform->NextFrame();
+  }
+
+  ReportFrameStats();
+}
+
+void Application::ReportFrameStats() {
+  std::cout << "frames: " << m_update_stats.count()
+            << ", ducks: " << m_ducks->count() << std::endl;
+  std::cout << "update ms: mean " << m_update_stats.Mean() << ", p50 "
+            << m_update_stats.Percentile(50) << ", p99 "
+            << m_update_stats.Percentile(99) << ", max "
+            << m_update_stats.Max() << std::endl;
+
+  if (m_interactive_pool->solver() != WaveSolver::Gpu) {
+    std::cout << "simulated water points: "
+              << m_interactive_pool->simulated_points() << " of "
+              << m_interactive_pool->resolution() + 1 << std::endl;
+  }
+
+  if (m_governor.IsEnabled()) {
+    std::cout << "quality level: " << m_governor.level()
+              << ", water resolution " << m_interactive_pool->resolution()
+              << std::endl;
+  }
+
+  double damage_percent =
+      m_damage_percent_sum / std::max<size_t>(m_update_stats.count(), 1);
+
+  std::cout << "foreground damage: mean " << damage_percent
+            << "% of the screen" << std::endl;
+
+  if (m_max_damage_percent > 0 && damage_percent > m_max_damage_percent) {
+    std::cerr << "foreground damage is above " << m_max_damage_percent << "%"
+              << std::endl;
+    m_exit_code = 1;
+  }
+}
+
+void Application::HandleProfilerKeys() {
+  if (m_platform->IsKeyPressed(KEY_F2)) {
+    WriteTrace(m_trace_path.empty() ? DEFAULT_TRACE_PATH : m_trace_path);
+  }
+
+  if (m_platform->IsKeyPressed(KEY_F3)) {
+    m_profiler_overlay = !m_profiler_overlay;
+  }
+}
+
+void Application::WriteTrace(const std::string &path) {
+  if (Profiler::Get().WriteChromeTrace(path)) {
+    std::cout << "trace written to " << path << std::endl;
+  } else {
+    std::cerr << "could not write trace to " << path << std::endl;
+  }
 }
 
 void Application::Update() {
-  float dt = GetFrameTime();
+  RAIN_PROFILE_ZONE("Application::Update");
 
-  timeout_counter += dt;
+  float frame_time = m_platform->GetFrameTime();
+  float step = 1.0f / m_step_rate;
+  int steps = 0;
+
+  timeout_counter += frame_time;
 
   if (timeout_counter >= m_quit_timeout) {
     m_should_close = true;
   }
 
-  m_rain->OnUpdate(dt);
-  m_interactive_pool->OnUpdate(dt);
+  if (m_simulation_paused) {
+    return;
+  }
+
+  m_accumulator += frame_time;
+
+  while (m_accumulator >= step && steps < m_max_simulation_steps) {
+    Step(step);
+
+    m_accumulator -= step;
+    steps++;
+  }
+
+  // A hitch longer than the catch-up cap is dropped instead of being
+  // simulated over the next frames
+  if (m_accumulator >= step) {
+    m_accumulator = fmodf(m_accumulator, step);
+  }
+
+  SetRenderAlpha(m_accumulator / step);
+  HandleProfilerKeys();
 
-  for (auto &duck : m_ducks) {
-    duck->OnUpdate(dt);
+  if (m_platform->IsKeyPressed(KEY_SPACE)) {
+    m_ducks->Spawn(m_platform->GetMousePosition());
   }
+}
+
+// The rain is independent of the water, while ducks sample the water surface,
+// so the rain runs alongside the pool and duck chain.
+void Application::Step(float dt) {
+  RAIN_PROFILE_ZONE("Application::Step");
+
+  JobCounter counter;
+
+  m_jobs->Submit(counter, [this, dt] { m_rain->OnUpdate(dt); });
+  m_jobs->Submit(counter, [this, dt] {
+    m_interactive_pool->OnUpdate(dt);
+    m_ducks->OnUpdate(dt);
+  });
+
+  m_jobs->Wait(counter);
+
+  m_interactive_pool->RunGpuSteps();
+
+  // Rain of the next step collides with this step's surface, and the pool
+  // applies the impulses of this step's rain
+  m_interactive_pool->SyncSurface();
+}
+
+void Application::SetRenderAlpha(float alpha) {
+  m_rain->render_alpha = alpha;
+  m_interactive_pool->render_alpha = alpha;
+
+  m_ducks->render_alpha = alpha;
+}
+
+void Application::Draw() {
+  RAIN_PROFILE_ZONE("Application::Draw");
+
+  DrawForeground();
+}
+
+// The frame costs whichever of the CPU and the GPU is slower. GPU timings
+// lag a few frames behind, which the governor's window absorbs.
+void Application::UpdateQuality(double cpu_ms) {
+  double frame_ms = cpu_ms;
+
+  if (m_gpu_timer != nullptr) {
+    frame_ms = std::max(frame_ms, m_gpu_timer->last_frame_ms());
+  }
+
+  if (m_governor.AddFrame(frame_ms)) {
+    ApplyQuality(m_governor.level());
+  }
+}
 
-  if (IsKeyPressed(KEY_SPACE)) {
-    Duck *duck = CreateDuck(m_duck_texture);
-    duck->transform.position = Vector2Subtract(
-        GetMousePosition(), Vector2Scale(duck->transform.size, 0.5));
+void Application::ApplyQuality(float level) {
+  m_rain->SetActiveLimit(
+      std::max(m_min_particles, (int)(m_max_particles * level)));
+  m_interactive_pool->SetResolution((int)(m_water_resolution * level));
 
-    m_ducks.push_back(std::unique_ptr<Duck>(duck));
+  float render_scale = std::max(MIN_RENDER_SCALE, level);
+
+  if (render_scale != m_render_scale) {
+    m_render_scale = render_scale;
+    m_foreground_damage.Invalidate();
   }
 }
 
-void Application::Draw() { DrawForeground(); }
+// Maps a screen rectangle to the whole pixels it covers in the scaled down
+// corner of the foreground, still counted from the top
+static Rectangle ToForegroundPixels(Rectangle rect, float scale_x,
+                                    float scale_y) {
+  float min_x = floorf(rect.x * scale_x);
+  float min_y = floorf(rect.y * scale_y);
+  float max_x = ceilf((rect.x + rect.width) * scale_x);
+  float max_y = ceilf((rect.y + rect.height) * scale_y);
+
+  return Rectangle{min_x, min_y, max_x - min_x, max_y - min_y};
+}
+
+// Flushes what was drawn under the previous scissor, scissor rectangles count
+// from the bottom of the framebuffer
+static void SetForegroundScissor(Rectangle rect, int height) {
+  rlDrawRenderBatchActive();
+  rlScissor((int)rect.x, height - (int)(rect.y + rect.height),
+            (int)rect.width, (int)rect.height);
+}
+
+// The foreground keeps its pixels between frames, so only the tiles rain and
+// water changed are cleared and drawn again
+void Application::TrackForegroundDamage() {
+  m_rain_rects.clear();
+  m_rain->GetDrawRects(m_rain_rects);
+
+  for (const Rectangle &rect : m_rain_rects) {
+    m_foreground_damage.AddDamage(rect);
+    m_foreground_damage.AddContent(rect);
+  }
+
+  m_foreground_damage.AddDamage(m_interactive_pool->GetDamageBounds());
+  m_foreground_damage.AddContent(m_interactive_pool->GetDrawBounds());
+}
 
 void Application::DrawForeground() {
+  GpuTimer *gpu_timer = m_gpu_timer.get();
+
+  if (gpu_timer != nullptr) {
+    gpu_timer->BeginFrame();
+  }
+
   BeginDrawing();
   ClearBackground(BLANK);
 
+  int width = m_foreground.texture.width;
+  int height = m_foreground.texture.height;
+  int scaled_width = (int)(width * m_render_scale);
+  int scaled_height = (int)(height * m_render_scale);
+  float scale_x = (float)scaled_width / width;
+  float scale_y = (float)scaled_height / height;
+
+  TrackForegroundDamage();
+  m_damage_pixels.clear();
+
+  for (const Rectangle &rect : m_foreground_damage.damage()) {
+    m_damage_pixels.push_back(ToForegroundPixels(rect, scale_x, scale_y));
+  }
+
+  Rectangle content = ToForegroundPixels(m_foreground_damage.content(),
+                                         scale_x, scale_y);
+
   BeginTextureMode(m_foreground);
-  ClearBackground(BLANK);
-  rlDisableColorBlend();
 
-  m_rain->OnDraw();
+  // The projection still covers the whole screen, so a smaller viewport
+  // renders the scene scaled down into the corner of the texture
+  rlViewport(0, 0, scaled_width, scaled_height);
+
+  if (!m_damage_pixels.empty()) {
+    Rectangle damage{};
 
-  m_interactive_pool->SetFoamColor(FOAM_COLOR);
-  m_interactive_pool->SetWaterColor(WATER_COLOR);
-  m_interactive_pool->OnDraw();
+    rlEnableScissorTest();
+
+    {
+      GpuPass pass(gpu_timer, "GPU foreground clear");
+
+      for (const Rectangle &rect : m_damage_pixels) {
+        SetForegroundScissor(rect, scaled_height);
+        ClearBackground(BLANK);
+        damage = RectangleUnion(damage, rect);
+      }
+    }
+
+    // Between the damage rectangles rain and water did not change, so one
+    // draw of each under their union writes the same pixels there again
+    SetForegroundScissor(damage, scaled_height);
+    rlDisableColorBlend();
+
+    {
+      GpuPass pass(gpu_timer, "GPU rain");
+
+      m_rain->OnDraw();
+    }
+
+    {
+      GpuPass pass(gpu_timer, "GPU water");
+
+      m_interactive_pool->OnDraw();
+    }
+
+    rlEnableColorBlend();
+    rlDrawRenderBatchActive();
+    rlDisableScissorTest();
+  }
 
-  rlEnableColorBlend();
   EndTextureMode();
 
-  for (auto &duck : m_ducks) {
-    duck->OnDraw();
+  {
+    GpuPass pass(gpu_timer, "GPU ducks");
+
+    m_ducks->OnDraw(*m_sprite_batch);
+    m_sprite_batch->Flush();
+  }
+
+  // Outside the content the foreground is transparent, so the blit skips it
+  if (!IsRectangleEmpty(content)) {
+    GpuPass pass(gpu_timer, "GPU foreground blit");
+
+    DrawTexturePro(m_foreground.texture,
+                   {content.x, scaled_height - content.y - content.height,
+                    content.width, -content.height},
+                   {content.x / scale_x, content.y / scale_y,
+                    content.width / scale_x, content.height / scale_y},
+                   {0, 0}, 0, WHITE);
   }
 
-  DrawTextureRec(m_foreground.texture,
-                 {0, 0, (float)m_foreground.texture.width,
-                  (float)-m_foreground.texture.height},
-                 {0, 0}, WHITE);
+  m_foreground_damage.EndFrame();
 
-  EndDrawing();
+  if (m_profiler_overlay) {
+    DrawProfilerOverlay();
+  }
+}
+
+void Application::DrawProfilerOverlay() {
+  const int font_size = 20;
+  const int line_height = 24;
+  std::vector<ZoneSummary> summaries = Profiler::Get().Summaries();
+  int y = 10;
+
+  // The default font is proportional, so every column has a fixed x
+  const int avg_x = 380;
+  const int p99_x = 490;
+
+  DrawRectangle(5, 5, 600, line_height * (summaries.size() + 1) + 10,
+                Fade(BLACK, 0.6f));
+  DrawText("zone", 10, y, font_size, WHITE);
+  DrawText("avg ms", avg_x, y, font_size, WHITE);
+  DrawText("p99 ms", p99_x, y, font_size, WHITE);
+
+  for (const ZoneSummary &summary : summaries) {
+    y += line_height;
+    DrawText(TextFormat("%.*s", (int)summary.name.size(), summary.name.data()),
+             10, y, font_size, WHITE);
+    DrawText(TextFormat("%.3f", summary.mean_ms), avg_x, y, font_size, WHITE);
+    DrawText(TextFormat("%.3f", summary.p99_ms), p99_x, y, font_size, WHITE);
+  }
 }
 
 void Application::Teardown() {
+  if (!m_trace_path.empty()) {
+    WriteTrace(m_trace_path);
+  }
+
+  if (m_headless) {
+    return;
+  }
+
+  m_rain->Unload();
+  m_interactive_pool->Unload();
   UnloadShader(m_rain_shader);
   UnloadShader(m_pool_shader);
+  UnloadShader(m_water_shader);
   UnloadTexture(m_default_texture);
-  UnloadTexture(m_duck_texture);
+  m_sprite_batch.reset();
+  m_gpu_timer.reset();
+  m_atlas.Unload();
   UnloadRenderTexture(m_foreground);
   CloseWindow();
 }
 
 ParticleSystem *Application::CreateRainParticleSystem(Shader shader) {
   ParticleSystem *particle_system = nullptr;
-  ParticleSystemOptions options{.shader = shader,
+  ParticleSystemOptions options{.platform = m_platform.get(),
+                                .jobs = m_jobs.get(),
+                                .shader = shader,
                                 .min_particles = m_min_particles,
                                 .max_particles = m_max_particles,
                                 .start_velocity = Vector2{-250, 1000},
                                 .start_size = Vector2{1, 40},
                                 .start_rotation = 10,
                                 .spawn_rate = 0.5,
-                                .color = RAIN_COLOR};
+                                .color = RAIN_COLOR,
+                                .mode = m_rain_mode};
 
   particle_system = new ParticleSystem(options);
   particle_system->transform.position = Vector2{-RAIN_OFFSET, 0};
   particle_system->transform.size =
-      Vector2{(float)GetScreenWidth() + RAIN_OFFSET, (float)GetScreenHeight()};
+      Vector2{(float)m_platform->GetScreenWidth() + RAIN_OFFSET,
+              (float)m_platform->GetScreenHeight()};
 
   return particle_system;
 }
 
 Pool *Application::CreatePool(Shader shader, Texture texture) {
   Pool *pool = nullptr;
-  PoolOptions options{.height_growth_rate = WATER_HEIGHT_GROWTH_RATE,
+  PoolOptions options{.platform = m_platform.get(),
+                      .height_growth_rate = WATER_HEIGHT_GROWTH_RATE,
                       .shader = shader,
                       .texture = texture,
                       .foam_color = FOAM_COLOR,
                       .water_color = WATER_COLOR,
                       .foam_width = FOAM_WIDTH,
-                      .max_height = (float)GetScreenHeight()};
+                      .max_height = (float)m_platform->GetScreenHeight()};
 
   pool = new Pool(options);
-  pool->transform.position = Vector2{0, (float)GetScreenHeight()};
-  pool->transform.size = Vector2{(float)GetScreenWidth(), 0};
+  pool->transform.position =
+      Vector2{0, (float)m_platform->GetScreenHeight()};
+  pool->transform.size = Vector2{(float)m_platform->GetScreenWidth(), 0};
 
   return pool;
 }
@@ -162,35 +575,46 @@ Pool *Application::CreatePool(Shader shader, Texture texture) {
 InteractivePool *Application::CreateInteractivePool(Shader shader,
                                                     Texture texture) {
   InteractivePool *interactive_pool = nullptr;
-  InteractivePoolOptions options{.resolution = 300,
+  InteractivePoolOptions options{.platform = m_platform.get(),
+                                 .jobs = m_jobs.get(),
+                                 .resolution = m_water_resolution,
                                  .height_growth_rate = WATER_HEIGHT_GROWTH_RATE,
                                  .shader = shader,
                                  .texture = texture,
                                  .foam_color = FOAM_COLOR,
                                  .water_color = WATER_COLOR,
                                  .foam_width = FOAM_WIDTH,
-                                 .max_height = (float)GetScreenHeight()};
+                                 .max_height =
+                                     (float)m_platform->GetScreenHeight(),
+                                 .solver = m_wave_solver,
+                                 .adaptive = m_adaptive_water};
 
   interactive_pool = new InteractivePool(options);
   interactive_pool->transform.position =
-      Vector2{-500, (float)GetScreenHeight()};
+      Vector2{-500, (float)m_platform->GetScreenHeight()};
   interactive_pool->transform.size =
-      Vector2{(float)GetScreenWidth() + 1000, 500};
+      Vector2{(float)m_platform->GetScreenWidth() + 1000, 500};
 
   return interactive_pool;
 }
 
-Duck *Application::CreateDuck(Texture texture) {
-  Duck *duck = new Duck(texture, m_interactive_pool.get());
-  Rigidbody2d *rigidbody = new Rigidbody2d(duck);
+DuckSystem *Application::CreateDuckSystem() {
+  Rectangle duck_source = {0, 0, 32, 32};
+
+  // The first 32x32 frame of the duck image, wherever the atlas placed it
+  if (m_duck_region >= 0) {
+    Rectangle region = m_atlas.region(m_duck_region);
 
-  rigidbody->SetMass(1.25);
+    duck_source.x = region.x;
+    duck_source.y = region.y;
+  }
 
-  duck->SetRigidbody2d(rigidbody);
-  duck->transform.position = Vector2{(float)GetScreenWidth() / 2 - 100,
-                                     (float)GetScreenHeight() / 2 - 100};
-  duck->transform.size = Vector2{200, 200};
+  DuckSystemOptions options{.jobs = m_jobs.get(),
+                            .interactive_pool = m_interactive_pool.get(),
+                            .sprite_source = duck_source,
+                            .size = Vector2{200, 200},
+                            .mass = 1.25};
 
-  return duck;
+  return new DuckSystem(options);
 }
 }; // namespace Rain
\ No newline at end of file
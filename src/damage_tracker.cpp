@@ -0,0 +1,191 @@
+#include <damage_tracker.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Rain {
+
+Rectangle RectangleUnion(Rectangle a, Rectangle b) {
+  if (IsRectangleEmpty(a)) {
+    return b;
+  }
+
+  if (IsRectangleEmpty(b)) {
+    return a;
+  }
+
+  float min_x = std::min(a.x, b.x);
+  float min_y = std::min(a.y, b.y);
+  float max_x = std::max(a.x + a.width, b.x + b.width);
+  float max_y = std::max(a.y + a.height, b.y + b.height);
+
+  return Rectangle{min_x, min_y, max_x - min_x, max_y - min_y};
+}
+
+bool IsRectangleEmpty(Rectangle rect) {
+  return rect.width <= 0 || rect.height <= 0;
+}
+
+DamageTracker::DamageTracker() : DamageTracker(Rectangle{}) {}
+
+DamageTracker::DamageTracker(Rectangle bounds)
+    : m_bounds(bounds), m_columns(0), m_rows(0), m_content{},
+      m_invalidated(true) {
+  if (!IsRectangleEmpty(bounds)) {
+    m_columns = (int)ceilf(bounds.width / TILE_SIZE);
+    m_rows = (int)ceilf(bounds.height / TILE_SIZE);
+  }
+
+  m_tiles.assign(m_columns * m_rows, 0);
+  m_previous_tiles.assign(m_columns * m_rows, 0);
+}
+
+void DamageTracker::AddDamage(Rectangle rect) {
+  rect = Clip(rect);
+
+  if (IsRectangleEmpty(rect)) {
+    return;
+  }
+
+  float x = rect.x - m_bounds.x;
+  float y = rect.y - m_bounds.y;
+  int first_column = (int)(x / TILE_SIZE);
+  int first_row = (int)(y / TILE_SIZE);
+  int end_column =
+      std::min(m_columns, (int)ceilf((x + rect.width) / TILE_SIZE));
+  int end_row = std::min(m_rows, (int)ceilf((y + rect.height) / TILE_SIZE));
+
+  for (int row = first_row; row < end_row; row++) {
+    uint8_t *tiles = m_tiles.data() + row * m_columns;
+
+    std::fill(tiles + first_column, tiles + end_column, 1);
+  }
+}
+
+void DamageTracker::AddContent(Rectangle rect) {
+  m_content = RectangleUnion(m_content, Clip(rect));
+}
+
+void DamageTracker::Invalidate() { m_invalidated = true; }
+
+const std::vector<Rectangle> &DamageTracker::damage() {
+  m_damage.clear();
+
+  if (m_invalidated) {
+    if (!IsRectangleEmpty(m_bounds)) {
+      m_damage.push_back(m_bounds);
+    }
+
+    return m_damage;
+  }
+
+  // Scattered damage makes too many rectangles of runs. Bands of whole rows
+  // of tiles always fit, their height grows with the row count.
+  if (!MergeRuns(false, 1)) {
+    MergeRuns(true, (m_rows + MAX_DAMAGE_RECTS - 1) / MAX_DAMAGE_RECTS);
+  }
+
+  for (Rectangle &rect : m_damage) {
+    rect = Clip(Rectangle{m_bounds.x + rect.x * TILE_SIZE,
+                          m_bounds.y + rect.y * TILE_SIZE,
+                          rect.width * TILE_SIZE, rect.height * TILE_SIZE});
+  }
+
+  return m_damage;
+}
+
+// Builds the damage rectangles in tile units from rows of `band` tiles. Runs
+// are the damaged tiles next to each other, or with `bands` everything from
+// the first to the last damaged column. A run extends the rectangle of the
+// run above it when both span the same columns.
+bool DamageTracker::MergeRuns(bool bands, int band) {
+  m_damage.clear();
+  m_previous_runs.clear();
+
+  for (int row = 0; row < m_rows; row += band) {
+    int rows = std::min(band, m_rows - row);
+    size_t above = 0;
+
+    m_runs.clear();
+
+    for (int column = 0; column < m_columns; column++) {
+      if (!IsTileDamaged(column, row, rows)) {
+        continue;
+      }
+
+      int end = column + 1;
+
+      for (int next = end; next < m_columns; next++) {
+        if (IsTileDamaged(next, row, rows)) {
+          end = next + 1;
+        } else if (!bands) {
+          break;
+        }
+      }
+
+      while (above < m_previous_runs.size() &&
+             m_previous_runs[above].begin < column) {
+        above++;
+      }
+
+      size_t rect = m_damage.size();
+
+      if (above < m_previous_runs.size() &&
+          m_previous_runs[above].begin == column &&
+          m_previous_runs[above].end == end) {
+        rect = m_previous_runs[above].rect;
+        m_damage[rect].height += rows;
+      } else {
+        m_damage.push_back(Rectangle{(float)column, (float)row,
+                                     (float)(end - column), (float)rows});
+      }
+
+      m_runs.push_back(Run{column, end, rect});
+      column = end;
+    }
+
+    std::swap(m_runs, m_previous_runs);
+  }
+
+  return m_damage.size() <= MAX_DAMAGE_RECTS;
+}
+
+Rectangle DamageTracker::content() const { return m_content; }
+
+void DamageTracker::EndFrame() {
+  std::swap(m_tiles, m_previous_tiles);
+  std::fill(m_tiles.begin(), m_tiles.end(), 0);
+  m_content = Rectangle{};
+  m_invalidated = false;
+}
+
+bool DamageTracker::IsTileDamaged(int column, int row, int rows) const {
+  for (int i = row; i < row + rows; i++) {
+    size_t index = i * m_columns + column;
+
+    if (m_tiles[index] || m_previous_tiles[index]) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+Rectangle DamageTracker::Clip(Rectangle rect) const {
+  if (IsRectangleEmpty(rect)) {
+    return Rectangle{};
+  }
+
+  float min_x = std::max(rect.x, m_bounds.x);
+  float min_y = std::max(rect.y, m_bounds.y);
+  float max_x = std::min(rect.x + rect.width, m_bounds.x + m_bounds.width);
+  float max_y = std::min(rect.y + rect.height, m_bounds.y + m_bounds.height);
+
+  if (max_x <= min_x || max_y <= min_y) {
+    return Rectangle{};
+  }
+
+  return Rectangle{min_x, min_y, max_x - min_x, max_y - min_y};
+}
+
+}; // namespace Rain
@@ -0,0 +1,200 @@
+#include "duck_system.h"
+#include "profiler.h"
+#include "raymath.h"
+
+#include <algorithm>
+
+namespace Rain {
+
+DuckSystem::DuckSystem(const DuckSystemOptions &options) : m_options(options) {}
+
+size_t DuckSystem::Spawn(Vector2 position) {
+  size_t index = count();
+  Transform transform;
+
+  transform.position = Vector2Subtract(position,
+                                       Vector2Scale(m_options.size, 0.5));
+  transform.size = m_options.size;
+
+  m_transforms.push_back(transform);
+  m_previous_positions.push_back(transform.position);
+  m_bodies.push_back(CreateRigidbody2d(m_options.mass));
+  m_sprites.push_back(Sprite{m_options.sprite_source, WHITE});
+  m_sample_ranges.push_back(WaterSampleRange{});
+  m_wave_ys.push_back(0);
+
+  m_grid.Insert(index, GetCenter(index));
+
+  return index;
+}
+
+void DuckSystem::OnUpdate(float dt) {
+  RAIN_PROFILE_ZONE("DuckSystem::OnUpdate");
+
+  size_t duck_count = count();
+
+  if (m_options.jobs == nullptr || duck_count <= UPDATE_CHUNK_SIZE) {
+    UpdateRange(dt, 0, duck_count);
+  } else {
+    JobCounter counter;
+
+    m_options.jobs->ParallelFor(counter, duck_count, UPDATE_CHUNK_SIZE,
+                                [this, dt](size_t begin, size_t end) {
+                                  UpdateRange(dt, begin, end);
+                                });
+    m_options.jobs->Wait(counter);
+  }
+
+  m_options.interactive_pool->AddFloatingBodies(m_sample_ranges.data(),
+                                                duck_count);
+  ResolveCollisions();
+}
+
+void DuckSystem::OnDraw(SpriteBatch &batch) {
+  for (size_t i = 0; i < count(); i++) {
+    const Transform &transform = m_transforms[i];
+    Vector2 position = Vector2Lerp(m_previous_positions[i],
+                                   transform.position, render_alpha);
+
+    batch.Add(m_sprites[i].source,
+              {position.x, position.y, transform.size.x, transform.size.y},
+              {0, 0}, transform.rotation, m_sprites[i].tint);
+  }
+}
+
+Vector2 DuckSystem::GetCenter(size_t index) const {
+  const Transform &transform = m_transforms[index];
+
+  return {transform.position.x + transform.size.x / 2,
+          transform.position.y + transform.size.y / 2};
+}
+
+void DuckSystem::UpdateRange(float dt, size_t begin, size_t end) {
+  RAIN_PROFILE_ZONE("DuckSystem::UpdateRange");
+
+  for (size_t i = begin; i < end; i++) {
+    m_previous_positions[i] = m_transforms[i].position;
+  }
+
+  IntegrateRigidbodies(m_bodies.data(), m_transforms.data(), begin, end, dt);
+
+  for (size_t i = begin; i < end; i++) {
+    AddForce(m_bodies[i], {0, GRAVITY * m_bodies[i].mass});
+  }
+
+  ApplyBuoyancy(begin, end);
+}
+
+// The water under every duck of the range is sampled in one batched query,
+// then ducks below the surface are pushed up in proportion to how deep they
+// are.
+void DuckSystem::ApplyBuoyancy(size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    const Transform &transform = m_transforms[i];
+
+    m_sample_ranges[i] = WaterSampleRange{
+        transform.position.x, transform.position.x + transform.size.x};
+  }
+
+  m_options.interactive_pool->SampleYFromRanges(
+      m_sample_ranges.data() + begin, m_wave_ys.data() + begin, end - begin);
+
+  for (size_t i = begin; i < end; i++) {
+    const Transform &transform = m_transforms[i];
+    Rigidbody2d &body = m_bodies[i];
+    float bottom = transform.position.y + transform.size.y;
+
+    if (bottom <= m_wave_ys[i]) {
+      continue;
+    }
+
+    float submerged_height =
+        std::max(0.0f, std::min(transform.size.y, bottom - m_wave_ys[i]));
+    float submersion = submerged_height / transform.size.y;
+
+    AddForce(body, {0, -submersion * GRAVITY * 5});
+    AddForce(body, {0, body.velocity.y * -2});
+    AddForce(body, {10, 0});
+  }
+}
+
+// Every duck is tested against the ducks of the 3x3 grid cells around it, so
+// the cost follows the number of close pairs instead of all pairs.
+void DuckSystem::ResolveCollisions() {
+  RAIN_PROFILE_ZONE("DuckSystem::ResolveCollisions");
+
+  for (size_t i = 0; i < count(); i++) {
+    m_grid.Move(i, GetCenter(i));
+  }
+
+  for (size_t i = 0; i < count(); i++) {
+    m_neighbors.clear();
+    m_grid.QueryNeighbors(GetCenter(i), m_neighbors);
+
+    for (int j : m_neighbors) {
+      // Each pair is resolved once, by its lower index
+      if ((size_t)j > i) {
+        ResolveCollision(i, j);
+      }
+    }
+  }
+}
+
+// Pushes two overlapping ducks apart along the axis of least penetration and
+// removes their approaching velocity with an impulse.
+void DuckSystem::ResolveCollision(size_t a, size_t b) {
+  Transform &ta = m_transforms[a];
+  Transform &tb = m_transforms[b];
+  float overlap_x = std::min(ta.position.x + ta.size.x,
+                             tb.position.x + tb.size.x) -
+                    std::max(ta.position.x, tb.position.x);
+  float overlap_y = std::min(ta.position.y + ta.size.y,
+                             tb.position.y + tb.size.y) -
+                    std::max(ta.position.y, tb.position.y);
+
+  if (overlap_x <= 0 || overlap_y <= 0) {
+    return;
+  }
+
+  Vector2 delta = Vector2Subtract(GetCenter(b), GetCenter(a));
+  Vector2 normal;
+  float penetration;
+
+  if (overlap_x < overlap_y) {
+    normal = Vector2{delta.x < 0 ? -1.0f : 1.0f, 0};
+    penetration = overlap_x;
+  } else {
+    normal = Vector2{0, delta.y < 0 ? -1.0f : 1.0f};
+    penetration = overlap_y;
+  }
+
+  Rigidbody2d &ra = m_bodies[a];
+  Rigidbody2d &rb = m_bodies[b];
+  float inverse_mass_sum = ra.inverse_mass + rb.inverse_mass;
+
+  if (inverse_mass_sum <= 0) {
+    return;
+  }
+
+  Vector2 correction = Vector2Scale(normal, penetration / inverse_mass_sum);
+
+  ta.position =
+      Vector2Subtract(ta.position, Vector2Scale(correction, ra.inverse_mass));
+  tb.position =
+      Vector2Add(tb.position, Vector2Scale(correction, rb.inverse_mass));
+
+  Vector2 relative_velocity = Vector2Subtract(rb.velocity, ra.velocity);
+  float approach_speed = Vector2DotProduct(relative_velocity, normal);
+
+  if (approach_speed >= 0) {
+    return;
+  }
+
+  Vector2 impulse = Vector2Scale(
+      normal, -(1 + RESTITUTION) * approach_speed / inverse_mass_sum);
+
+  ApplyImpulse(ra, Vector2Negate(impulse));
+  ApplyImpulse(rb, impulse);
+}
+
+}; // namespace Rain
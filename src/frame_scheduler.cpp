@@ -0,0 +1,56 @@
+#include "frame_scheduler.h"
+
+#include <algorithm>
+
+namespace Rain {
+
+FrameScheduler::FrameScheduler(const FrameSchedulerOptions &options)
+    : m_options(options) {}
+
+bool FrameScheduler::Update(Platform &platform, float frame_time) {
+  FrameState state;
+
+  if (platform.HasInput()) {
+    m_time_since_input = 0;
+  } else {
+    m_time_since_input += frame_time;
+  }
+
+  if (platform.IsMinimized() || platform.IsHidden()) {
+    state = FrameState::Idle;
+  } else if (platform.IsFocused() ||
+             m_time_since_input < m_options.background_delay) {
+    state = FrameState::Active;
+  } else {
+    state = FrameState::Background;
+  }
+
+  if (state == m_state) {
+    return false;
+  }
+
+  m_state = state;
+
+  return true;
+}
+
+int FrameScheduler::target_fps() const {
+  switch (m_state) {
+  case FrameState::Background:
+    return m_options.background_fps;
+  case FrameState::Idle:
+    return m_options.idle_fps;
+  default:
+    return m_options.active_fps;
+  }
+}
+
+float FrameScheduler::SimulationRate(float active_rate) const {
+  if (m_state == FrameState::Background) {
+    return std::min(active_rate, m_options.background_simulation_rate);
+  }
+
+  return active_rate;
+}
+
+}; // namespace Rain
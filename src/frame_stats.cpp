@@ -0,0 +1,43 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Rain {
+
+double FrameStats::Mean() const {
+  double sum = 0;
+
+  if (m_samples.empty()) {
+    return 0;
+  }
+
+  for (double sample : m_samples) {
+    sum += sample;
+  }
+
+  return sum / m_samples.size();
+}
+
+double FrameStats::Max() const {
+  if (m_samples.empty()) {
+    return 0;
+  }
+
+  return *std::max_element(m_samples.begin(), m_samples.end());
+}
+
+double FrameStats::Percentile(double p) const {
+  if (m_samples.empty()) {
+    return 0;
+  }
+
+  std::vector<double> sorted = m_samples;
+  size_t index = (size_t)std::round(p / 100.0 * (sorted.size() - 1));
+
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+
+  return sorted[index];
+}
+
+}; // namespace Rain
@@ -0,0 +1,166 @@
+#include "gpu_timer.h"
+#include "profiler.h"
+
+#include <rlgl.h>
+
+namespace Rain {
+
+// rlgl does not expose queries, so the ARB_timer_query entry points (core
+// since GL 3.3) are loaded through GLFW, which raylib uses on desktop.
+#if defined(_WIN32)
+#define RAIN_GL_API __stdcall
+#else
+#define RAIN_GL_API
+#endif
+
+constexpr unsigned int GL_QUERY_RESULT = 0x8866;
+constexpr unsigned int GL_QUERY_RESULT_AVAILABLE = 0x8867;
+constexpr unsigned int GL_TIMESTAMP = 0x8E28;
+
+using GenQueriesProc = void(RAIN_GL_API *)(int, unsigned int *);
+using DeleteQueriesProc = void(RAIN_GL_API *)(int, const unsigned int *);
+using QueryCounterProc = void(RAIN_GL_API *)(unsigned int, unsigned int);
+using GetQueryObjectivProc = void(RAIN_GL_API *)(unsigned int, unsigned int,
+                                                 int *);
+using GetQueryObjectui64vProc = void(RAIN_GL_API *)(unsigned int,
+                                                    unsigned int, uint64_t *);
+using GetInteger64vProc = void(RAIN_GL_API *)(unsigned int, int64_t *);
+
+static GenQueriesProc s_gen_queries = nullptr;
+static DeleteQueriesProc s_delete_queries = nullptr;
+static QueryCounterProc s_query_counter = nullptr;
+static GetQueryObjectivProc s_get_query_objectiv = nullptr;
+static GetQueryObjectui64vProc s_get_query_objectui64v = nullptr;
+static GetInteger64vProc s_get_integer64v = nullptr;
+
+#if defined(PLATFORM_DESKTOP)
+extern "C" {
+typedef void (*GLFWglproc)(void);
+GLFWglproc glfwGetProcAddress(const char *procname);
+}
+
+static bool LoadQueryFunctions() {
+  s_gen_queries = (GenQueriesProc)glfwGetProcAddress("glGenQueries");
+  s_delete_queries = (DeleteQueriesProc)glfwGetProcAddress("glDeleteQueries");
+  s_query_counter = (QueryCounterProc)glfwGetProcAddress("glQueryCounter");
+  s_get_query_objectiv =
+      (GetQueryObjectivProc)glfwGetProcAddress("glGetQueryObjectiv");
+  s_get_query_objectui64v =
+      (GetQueryObjectui64vProc)glfwGetProcAddress("glGetQueryObjectui64v");
+  s_get_integer64v = (GetInteger64vProc)glfwGetProcAddress("glGetInteger64v");
+
+  return s_gen_queries && s_delete_queries && s_query_counter &&
+         s_get_query_objectiv && s_get_query_objectui64v && s_get_integer64v;
+}
+#else
+static bool LoadQueryFunctions() { return false; }
+#endif
+
+GpuTimer::GpuTimer() {
+  m_supported = LoadQueryFunctions();
+
+  if (!m_supported) {
+    return;
+  }
+
+  for (Frame &frame : m_frames) {
+    s_gen_queries(2 * MAX_PASSES, frame.queries);
+  }
+
+  int64_t gpu_now_ns = 0;
+
+  s_get_integer64v(GL_TIMESTAMP, &gpu_now_ns);
+  m_clock_offset_ns = (int64_t)Profiler::Get().Now() - gpu_now_ns;
+}
+
+GpuTimer::~GpuTimer() {
+  if (!m_supported) {
+    return;
+  }
+
+  for (Frame &frame : m_frames) {
+    s_delete_queries(2 * MAX_PASSES, frame.queries);
+  }
+}
+
+void GpuTimer::BeginFrame() {
+  if (!m_supported) {
+    return;
+  }
+
+  m_frame++;
+
+  Frame &frame = CurrentFrame();
+
+  ReadBack(frame);
+  frame.pass_count = 0;
+}
+
+void GpuTimer::BeginPass(const char *name) {
+  Frame &frame = CurrentFrame();
+
+  if (!m_supported || frame.pass_count >= MAX_PASSES) {
+    return;
+  }
+
+  // rlgl batches draws, they have to be submitted to land inside the pass
+  rlDrawRenderBatchActive();
+
+  frame.names[frame.pass_count] = name;
+  s_query_counter(frame.queries[2 * frame.pass_count], GL_TIMESTAMP);
+}
+
+void GpuTimer::EndPass() {
+  Frame &frame = CurrentFrame();
+
+  if (!m_supported || frame.pass_count >= MAX_PASSES) {
+    return;
+  }
+
+  rlDrawRenderBatchActive();
+
+  s_query_counter(frame.queries[2 * frame.pass_count + 1], GL_TIMESTAMP);
+  frame.pass_count++;
+}
+
+// The GPU finishes commands in order, so once the last query of a frame is
+// available all of them are. A frame that is still in flight after
+// FRAME_LATENCY frames is dropped instead of waited for.
+void GpuTimer::ReadBack(Frame &frame) {
+  if (frame.pass_count == 0) {
+    return;
+  }
+
+  int available = 0;
+
+  s_get_query_objectiv(frame.queries[2 * frame.pass_count - 1],
+                       GL_QUERY_RESULT_AVAILABLE, &available);
+
+  if (!available) {
+    return;
+  }
+
+  uint64_t frame_start_ns = 0;
+  uint64_t frame_end_ns = 0;
+
+  for (int i = 0; i < frame.pass_count; i++) {
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+
+    s_get_query_objectui64v(frame.queries[2 * i], GL_QUERY_RESULT, &start_ns);
+    s_get_query_objectui64v(frame.queries[2 * i + 1], GL_QUERY_RESULT,
+                            &end_ns);
+
+    Profiler::Get().RecordTrack(
+        "GPU", ProfileEvent{frame.names[i],
+                            (uint64_t)(start_ns + m_clock_offset_ns),
+                            (uint64_t)(end_ns + m_clock_offset_ns)});
+
+    frame_start_ns = i == 0 ? start_ns : frame_start_ns;
+    frame_end_ns = end_ns;
+  }
+
+  m_last_frame_ms = (frame_end_ns - frame_start_ns) / 1e6;
+}
+
+}; // namespace Rain
@@ -0,0 +1,413 @@
+#include "gpu_water_sim.h"
+
+#include <rlgl.h>
+
+#include <algorithm>
+
+namespace Rain {
+
+// rlgl has no pixel buffers or fences, so they are loaded through GLFW like
+// the timer queries of GpuTimer.
+#if defined(_WIN32)
+#define RAIN_GL_API __stdcall
+#else
+#define RAIN_GL_API
+#endif
+
+constexpr unsigned int GL_FLOAT = 0x1406;
+constexpr unsigned int GL_RGBA = 0x1908;
+constexpr unsigned int GL_PIXEL_PACK_BUFFER = 0x88EB;
+constexpr unsigned int GL_STREAM_READ = 0x88E1;
+constexpr unsigned int GL_MAP_READ_BIT = 0x0001;
+constexpr unsigned int GL_SYNC_GPU_COMMANDS_COMPLETE = 0x9117;
+constexpr unsigned int GL_ALREADY_SIGNALED = 0x911A;
+constexpr unsigned int GL_CONDITION_SATISFIED = 0x911C;
+
+using GenBuffersProc = void(RAIN_GL_API *)(int, unsigned int *);
+using DeleteBuffersProc = void(RAIN_GL_API *)(int, const unsigned int *);
+using BindBufferProc = void(RAIN_GL_API *)(unsigned int, unsigned int);
+using BufferDataProc = void(RAIN_GL_API *)(unsigned int, ptrdiff_t,
+                                           const void *, unsigned int);
+using ReadPixelsProc = void(RAIN_GL_API *)(int, int, int, int, unsigned int,
+                                           unsigned int, void *);
+using MapBufferRangeProc = void *(RAIN_GL_API *)(unsigned int, ptrdiff_t,
+                                                 ptrdiff_t, unsigned int);
+using UnmapBufferProc = unsigned char(RAIN_GL_API *)(unsigned int);
+using FenceSyncProc = void *(RAIN_GL_API *)(unsigned int, unsigned int);
+using ClientWaitSyncProc = unsigned int(RAIN_GL_API *)(void *, unsigned int,
+                                                       uint64_t);
+using DeleteSyncProc = void(RAIN_GL_API *)(void *);
+
+static GenBuffersProc s_gen_buffers = nullptr;
+static DeleteBuffersProc s_delete_buffers = nullptr;
+static BindBufferProc s_bind_buffer = nullptr;
+static BufferDataProc s_buffer_data = nullptr;
+static ReadPixelsProc s_read_pixels = nullptr;
+static MapBufferRangeProc s_map_buffer_range = nullptr;
+static UnmapBufferProc s_unmap_buffer = nullptr;
+static FenceSyncProc s_fence_sync = nullptr;
+static ClientWaitSyncProc s_client_wait_sync = nullptr;
+static DeleteSyncProc s_delete_sync = nullptr;
+
+#if defined(PLATFORM_DESKTOP)
+extern "C" {
+typedef void (*GLFWglproc)(void);
+GLFWglproc glfwGetProcAddress(const char *procname);
+}
+
+static bool LoadReadbackFunctions() {
+  s_gen_buffers = (GenBuffersProc)glfwGetProcAddress("glGenBuffers");
+  s_delete_buffers = (DeleteBuffersProc)glfwGetProcAddress("glDeleteBuffers");
+  s_bind_buffer = (BindBufferProc)glfwGetProcAddress("glBindBuffer");
+  s_buffer_data = (BufferDataProc)glfwGetProcAddress("glBufferData");
+  s_read_pixels = (ReadPixelsProc)glfwGetProcAddress("glReadPixels");
+  s_map_buffer_range =
+      (MapBufferRangeProc)glfwGetProcAddress("glMapBufferRange");
+  s_unmap_buffer = (UnmapBufferProc)glfwGetProcAddress("glUnmapBuffer");
+  s_fence_sync = (FenceSyncProc)glfwGetProcAddress("glFenceSync");
+  s_client_wait_sync =
+      (ClientWaitSyncProc)glfwGetProcAddress("glClientWaitSync");
+  s_delete_sync = (DeleteSyncProc)glfwGetProcAddress("glDeleteSync");
+
+  return s_gen_buffers && s_delete_buffers && s_bind_buffer &&
+         s_buffer_data && s_read_pixels && s_map_buffer_range &&
+         s_unmap_buffer && s_fence_sync && s_client_wait_sync &&
+         s_delete_sync;
+}
+#else
+static bool LoadReadbackFunctions() { return false; }
+#endif
+
+// A render target of one row of float texels
+static RenderTexture LoadRowTarget(int width, int format) {
+  RenderTexture target = {};
+
+  target.id = rlLoadFramebuffer();
+  target.texture.id = rlLoadTexture(nullptr, width, 1, format, 1);
+  target.texture.width = width;
+  target.texture.height = 1;
+  target.texture.mipmaps = 1;
+  target.texture.format = format;
+
+  rlFramebufferAttach(target.id, target.texture.id,
+                      RL_ATTACHMENT_COLOR_CHANNEL0, RL_ATTACHMENT_TEXTURE2D,
+                      0);
+
+  return target;
+}
+
+GpuWaterSim::GpuWaterSim(int capacity)
+    : m_capacity(capacity),
+      m_step_shader(LoadShader(0, "resources/shaders/water_step.fs")),
+      m_splat_shader(LoadShader(0, "resources/shaders/water_splat.fs")),
+      m_resample_shader(LoadShader(0, "resources/shaders/water_resample.fs")),
+      m_step_material(m_step_shader), m_splat_material(m_splat_shader),
+      m_resample_material(m_resample_shader) {
+  if (!LoadReadbackFunctions()) {
+    return;
+  }
+
+  for (RenderTexture &state : m_states) {
+    state = LoadRowTarget(capacity, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+  }
+
+  m_impulses = LoadRowTarget(capacity, PIXELFORMAT_UNCOMPRESSED_R32);
+  m_readback =
+      LoadRowTarget(READBACK_WIDTH, PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+
+  m_impulse_upload.id =
+      rlLoadTexture(nullptr, capacity, 1, PIXELFORMAT_UNCOMPRESSED_R32, 1);
+  m_impulse_upload.width = capacity;
+  m_impulse_upload.height = 1;
+  m_impulse_upload.mipmaps = 1;
+  m_impulse_upload.format = PIXELFORMAT_UNCOMPRESSED_R32;
+
+  for (Readback &readback : m_readbacks) {
+    s_gen_buffers(1, &readback.buffer);
+    s_bind_buffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    s_buffer_data(GL_PIXEL_PACK_BUFFER, READBACK_WIDTH * 4 * sizeof(float),
+                  nullptr, GL_STREAM_READ);
+  }
+
+  s_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  m_supported = rlFramebufferComplete(m_states[0].id) &&
+                rlFramebufferComplete(m_states[1].id) &&
+                rlFramebufferComplete(m_impulses.id) &&
+                rlFramebufferComplete(m_readback.id);
+
+  LoadMaterials();
+}
+
+GpuWaterSim::~GpuWaterSim() {
+  for (Readback &readback : m_readbacks) {
+    if (readback.fence != nullptr) {
+      s_delete_sync(readback.fence);
+    }
+
+    if (readback.buffer != 0) {
+      s_delete_buffers(1, &readback.buffer);
+    }
+  }
+
+  for (const RenderTexture &target :
+       {m_states[0], m_states[1], m_impulses, m_readback}) {
+    if (target.id != 0) {
+      UnloadRenderTexture(target);
+    }
+  }
+
+  if (m_impulse_upload.id != 0) {
+    rlUnloadTexture(m_impulse_upload.id);
+  }
+
+  UnloadShader(m_step_shader);
+  UnloadShader(m_splat_shader);
+  UnloadShader(m_resample_shader);
+}
+
+void GpuWaterSim::LoadMaterials() {
+  m_step_impulses_loc = GetShaderLocation(m_step_shader, "impulses");
+  m_count_uniform = m_step_material.AddUniform("count", SHADER_UNIFORM_INT);
+  m_dt_uniform = m_step_material.AddUniform("dt", SHADER_UNIFORM_FLOAT);
+  m_spring_uniform =
+      m_step_material.AddUniform("springConstant", SHADER_UNIFORM_FLOAT);
+  m_baseline_uniform =
+      m_step_material.AddUniform("baselineConstant", SHADER_UNIFORM_FLOAT);
+  m_damping_uniform =
+      m_step_material.AddUniform("damping", SHADER_UNIFORM_FLOAT);
+  m_rest_uniform = m_step_material.AddUniform("rest", SHADER_UNIFORM_FLOAT);
+  m_first_x_uniform =
+      m_step_material.AddUniform("firstX", SHADER_UNIFORM_FLOAT);
+  m_column_width_uniform =
+      m_step_material.AddUniform("columnWidth", SHADER_UNIFORM_FLOAT);
+  m_amplitudes_uniform =
+      m_step_material.AddUniform("waveAmplitudes", SHADER_UNIFORM_VEC4);
+  m_wave_numbers_uniform =
+      m_step_material.AddUniform("waveNumbers", SHADER_UNIFORM_VEC4);
+  m_phases_uniform =
+      m_step_material.AddUniform("wavePhases", SHADER_UNIFORM_VEC4);
+
+  m_splat_state_loc = GetShaderLocation(m_splat_shader, "state");
+  m_splat_center_uniform =
+      m_splat_material.AddUniform("center", SHADER_UNIFORM_VEC2);
+  m_splat_first_x_uniform =
+      m_splat_material.AddUniform("firstX", SHADER_UNIFORM_FLOAT);
+  m_splat_column_width_uniform =
+      m_splat_material.AddUniform("columnWidth", SHADER_UNIFORM_FLOAT);
+  m_splat_rest_uniform =
+      m_splat_material.AddUniform("rest", SHADER_UNIFORM_FLOAT);
+  m_splat_position_uniform =
+      m_splat_material.AddUniform("interactor", SHADER_UNIFORM_VEC2);
+  m_splat_radius_uniform =
+      m_splat_material.AddUniform("radius", SHADER_UNIFORM_FLOAT);
+  m_splat_strength_uniform =
+      m_splat_material.AddUniform("strength", SHADER_UNIFORM_FLOAT);
+  m_splat_max_influence_uniform =
+      m_splat_material.AddUniform("maxInfluence", SHADER_UNIFORM_FLOAT);
+
+  m_source_count_uniform =
+      m_resample_material.AddUniform("sourceCount", SHADER_UNIFORM_INT);
+  m_target_count_uniform =
+      m_resample_material.AddUniform("targetCount", SHADER_UNIFORM_INT);
+}
+
+void GpuWaterSim::Upload(const std::vector<Vector4> &points) {
+  m_count = std::min((int)points.size(), m_capacity);
+
+  rlUpdateTexture(m_states[m_current].texture.id, 0, 0, m_count, 1,
+                  PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, points.data());
+  rlUpdateTexture(m_states[1 - m_current].texture.id, 0, 0, m_count, 1,
+                  PIXELFORMAT_UNCOMPRESSED_R32G32B32A32, points.data());
+}
+
+void GpuWaterSim::Resample(int count) {
+  count = std::clamp(count, 1, m_capacity);
+
+  if (count == m_count) {
+    return;
+  }
+
+  ResampleRow(m_states[m_current].texture, m_count, m_states[1 - m_current],
+              count);
+  m_current = 1 - m_current;
+  m_count = count;
+
+  // Drawing interpolates from the previous state, which needs the same layout
+  ResampleRow(m_states[m_current].texture, count, m_states[1 - m_current],
+              count);
+}
+
+void GpuWaterSim::Step(const GpuWaterStep &step, const float *impulses,
+                       const GpuWaterSplat *splats, int splat_count) {
+  RenderTexture &source = m_states[m_current];
+  RenderTexture &target = m_states[1 - m_current];
+
+  DrawImpulses(step, impulses, splats, splat_count);
+
+  m_step_material.SetInt(m_count_uniform, m_count);
+  m_step_material.SetFloat(m_dt_uniform, step.dt);
+  m_step_material.SetFloat(m_spring_uniform, step.spring_constant);
+  m_step_material.SetFloat(m_baseline_uniform, step.baseline_constant);
+  m_step_material.SetFloat(m_damping_uniform, step.damping);
+  m_step_material.SetFloat(m_rest_uniform, step.rest);
+  m_step_material.SetFloat(m_first_x_uniform, step.first_x);
+  m_step_material.SetFloat(m_column_width_uniform, step.column_width);
+  m_step_material.SetVector4(m_amplitudes_uniform, step.wave_amplitudes);
+  m_step_material.SetVector4(m_wave_numbers_uniform, step.wave_numbers);
+  m_step_material.SetVector4(m_phases_uniform, step.wave_phases);
+
+  BeginTextureMode(target);
+  rlDisableColorBlend();
+  BeginShaderMode(m_step_shader);
+
+  m_step_material.Bind();
+  SetShaderValueTexture(m_step_shader, m_step_impulses_loc,
+                        m_impulses.texture);
+  DrawTextureRec(source.texture, Rectangle{0, 0, (float)m_count, 1},
+                 Vector2{0, 0}, WHITE);
+
+  EndShaderMode();
+  rlEnableColorBlend();
+  EndTextureMode();
+
+  m_current = 1 - m_current;
+}
+
+// The rain impulses are copied into the row as they are, then every splat is
+// added on top with additive blending.
+void GpuWaterSim::DrawImpulses(const GpuWaterStep &step, const float *impulses,
+                               const GpuWaterSplat *splats, int splat_count) {
+  rlUpdateTexture(m_impulse_upload.id, 0, 0, m_count, 1,
+                  PIXELFORMAT_UNCOMPRESSED_R32, impulses);
+
+  BeginTextureMode(m_impulses);
+  rlDisableColorBlend();
+  DrawTextureRec(m_impulse_upload, Rectangle{0, 0, (float)m_count, 1},
+                 Vector2{0, 0}, WHITE);
+  rlDrawRenderBatchActive();
+  rlEnableColorBlend();
+
+  if (splat_count > 0) {
+    m_splat_material.SetVector2(m_splat_center_uniform, step.center);
+    m_splat_material.SetFloat(m_splat_first_x_uniform, step.first_x);
+    m_splat_material.SetFloat(m_splat_column_width_uniform, step.column_width);
+    m_splat_material.SetFloat(m_splat_rest_uniform, step.rest);
+
+    rlSetBlendFactors(RL_ONE, RL_ONE, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM);
+  }
+
+  for (int i = 0; i < splat_count; i++) {
+    const GpuWaterSplat &splat = splats[i];
+    int begin = std::max(splat.begin, 0);
+    int end = std::min(splat.end, m_count);
+
+    if (begin >= end) {
+      continue;
+    }
+
+    m_splat_material.SetVector2(m_splat_position_uniform, splat.position);
+    m_splat_material.SetFloat(m_splat_radius_uniform, splat.radius);
+    m_splat_material.SetFloat(m_splat_strength_uniform, splat.strength);
+    m_splat_material.SetFloat(m_splat_max_influence_uniform,
+                              splat.max_influence);
+
+    BeginShaderMode(m_splat_shader);
+
+    m_splat_material.Bind();
+    SetShaderValueTexture(m_splat_shader, m_splat_state_loc,
+                          m_states[m_current].texture);
+    DrawRectangleRec(Rectangle{(float)begin, 0, (float)(end - begin), 1},
+                     WHITE);
+
+    EndShaderMode();
+  }
+
+  if (splat_count > 0) {
+    EndBlendMode();
+  }
+
+  EndTextureMode();
+}
+
+void GpuWaterSim::ResampleRow(Texture source, int source_count,
+                              RenderTexture &target, int target_count) {
+  m_resample_material.SetInt(m_source_count_uniform, source_count);
+  m_resample_material.SetInt(m_target_count_uniform, target_count);
+
+  BeginTextureMode(target);
+  rlDisableColorBlend();
+  BeginShaderMode(m_resample_shader);
+
+  m_resample_material.Bind();
+  DrawTextureRec(source, Rectangle{0, 0, (float)target_count, 1},
+                 Vector2{0, 0}, WHITE);
+
+  EndShaderMode();
+  rlEnableColorBlend();
+  EndTextureMode();
+}
+
+void GpuWaterSim::RequestReadback() {
+  Readback &readback = m_readbacks[m_readback_next % READBACK_BUFFERS];
+
+  if (readback.fence != nullptr) {
+    return;
+  }
+
+  int width = std::min(READBACK_WIDTH, m_count);
+
+  ResampleRow(m_states[m_current].texture, m_count, m_readback, width);
+
+  // Reads into the bound pixel buffer return right away, the copy happens
+  // on the GPU timeline
+  rlEnableFramebuffer(m_readback.id);
+  s_bind_buffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+  s_read_pixels(0, 0, width, 1, GL_RGBA, GL_FLOAT, nullptr);
+  s_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+  rlDisableFramebuffer();
+
+  readback.fence = s_fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  readback.count = width;
+  m_readback_next++;
+}
+
+bool GpuWaterSim::PollReadback(std::vector<float> &ys) {
+  bool updated = false;
+
+  while (m_readback_oldest < m_readback_next) {
+    Readback &readback = m_readbacks[m_readback_oldest % READBACK_BUFFERS];
+    unsigned int status = s_client_wait_sync(readback.fence, 0, 0);
+
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+
+    s_bind_buffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+
+    const float *texels = (const float *)s_map_buffer_range(
+        GL_PIXEL_PACK_BUFFER, 0, readback.count * 4 * sizeof(float),
+        GL_MAP_READ_BIT);
+
+    if (texels != nullptr) {
+      ys.resize(readback.count);
+
+      for (int i = 0; i < readback.count; i++) {
+        ys[i] = texels[4 * i + 2];
+      }
+
+      s_unmap_buffer(GL_PIXEL_PACK_BUFFER);
+      updated = true;
+    }
+
+    s_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
+    s_delete_sync(readback.fence);
+    readback.fence = nullptr;
+    m_readback_oldest++;
+  }
+
+  return updated;
+}
+
+}; // namespace Rain
@@ -1,4 +1,5 @@
 #include "interactive_pool.h"
+#include "profiler.h"
 #include "raylib.h"
 #include "raymath.h"
 #include "utils.h"
@@ -8,24 +9,65 @@ namespace Rain {
 InteractivePool::InteractivePool() {}
 
 InteractivePool::InteractivePool(const InteractivePoolOptions &options)
-    : m_height_growth_rate(options.height_growth_rate),
-      m_resolution(options.resolution), m_shader(options.shader),
-      m_texture(options.texture), m_foam_color(options.foam_color),
-      m_water_color(options.water_color), m_foam_width(options.foam_width),
-      m_max_height(options.max_height) {}
+    : m_platform(options.platform), m_resolution(options.resolution),
+      m_max_resolution(options.resolution),
+      m_height_growth_rate(options.height_growth_rate),
+      m_shader(options.shader), m_material(options.shader),
+      m_texture(options.texture),
+      m_foam_color(options.foam_color), m_water_color(options.water_color),
+      m_foam_width(options.foam_width), m_max_height(options.max_height),
+      m_solver(options.solver),
+      m_adaptive(options.adaptive && options.solver == WaveSolver::Implicit),
+      m_surface(options.jobs != nullptr ? options.jobs->thread_count() : 1) {}
 
 void InteractivePool::Init() {
   float step = transform.size.x / m_resolution;
 
+  m_wave_points.reserve(m_max_resolution + 1);
+  m_resample_scratch.reserve(m_max_resolution + 1);
+  m_background_heights.reserve(m_max_resolution + 1);
+  m_surface_ys.reserve(m_max_resolution + 1);
+  m_solver_upper.reserve(m_max_resolution + 1);
+  m_solver_rhs.reserve(m_max_resolution + 1);
+  m_height_prefix.reserve(m_max_resolution + 2);
+  m_active_points.reserve(m_max_resolution + 1);
+  m_active_masses.reserve(m_max_resolution + 1);
+  m_active_impulses.reserve(m_max_resolution + 1);
+
   for (int i = 0; i < m_resolution + 1; i++) {
     WavePoint wave_point = {
         Vector2{-transform.size.x / 2 + step * i, -transform.size.y / 2},
         Vector2{0, 0},
         Vector2{-transform.size.x / 2 + step * i, -transform.size.y / 2},
+        Vector2{-transform.size.x / 2 + step * i, -transform.size.y / 2},
         Vector2{-transform.size.x / 2 + step * i, -transform.size.y / 2}};
 
     m_wave_points.push_back(wave_point);
   }
+
+  for (int i = 0; i < MAX_BACKGROUND_WAVES; i++) {
+    m_wave_phases[i] = m_waves_parameters[i][3];
+  }
+
+  AdvanceWavePhases(0);
+
+  m_background_heights.resize(m_wave_points.size());
+  m_height_prefix.resize(m_wave_points.size() + 1);
+  ResetBlocks();
+  UpdateHeightPrefix();
+  SyncSurface();
+  m_previous_transform = transform;
+  m_interactors.push_back(
+      WaveInteractor{m_platform->GetMousePosition(), INFLUENCE_RADIUS,
+                     INFLUENCE_FORCE});
+
+  if (!m_platform->IsHeadless()) {
+    LoadRenderData();
+  }
+
+  if (m_solver == WaveSolver::Gpu) {
+    LoadGpuSimulation();
+  }
 }
 
 void InteractivePool::OnDraw() {
@@ -37,24 +79,83 @@ void InteractivePool::OnDraw() {
 }
 
 void InteractivePool::OnUpdate(float dt) {
-  m_total_time += dt;
+  AdvanceWavePhases(dt);
+
+  m_previous_transform = transform;
 
   transform.size.y += m_height_growth_rate * dt;
   transform.position.y -= m_height_growth_rate * dt;
 
+  if (m_gpu != nullptr) {
+    m_interactors[MOUSE_INTERACTOR].position = m_platform->GetMousePosition();
+    m_gpu_steps.push_back(dt);
+    return;
+  }
+
   UpdateWavePoints(dt);
 }
 
-void InteractivePool::SetWaterColor(Color color) { m_water_color = color; }
+// Every point takes the state of the old surface linearly interpolated at its
+// x, so the waves keep their shape across the change.
+void InteractivePool::SetResolution(int resolution) {
+  int min_resolution = std::min(MIN_RESOLUTION, m_max_resolution);
 
-void InteractivePool::SetFoamColor(Color color) { m_foam_color = color; }
+  resolution = std::clamp(resolution, min_resolution, m_max_resolution);
 
-std::vector<float> InteractivePool::normalized_foam_color() {
-  return NormalizeColor(m_foam_color);
+  if (resolution == m_resolution || m_wave_points.empty()) {
+    return;
+  }
+
+  m_resample_scratch.assign(m_wave_points.begin(), m_wave_points.end());
+
+  size_t old_last = m_resample_scratch.size() - 1;
+  float step = transform.size.x / resolution;
+
+  m_wave_points.resize(resolution + 1);
+
+  for (int i = 0; i < resolution + 1; i++) {
+    float source = (float)i * old_last / resolution;
+    size_t left = std::min((size_t)source, old_last);
+    size_t right = std::min(left + 1, old_last);
+    float t = source - left;
+    const WavePoint &a = m_resample_scratch[left];
+    const WavePoint &b = m_resample_scratch[right];
+    WavePoint &point = m_wave_points[i];
+    float x = -transform.size.x / 2 + step * i;
+
+    point.position = Vector2{x, Lerp(a.position.y, b.position.y, t)};
+    point.velocity = Vector2Lerp(a.velocity, b.velocity, t);
+    point.offset = Vector2{x, Lerp(a.offset.y, b.offset.y, t)};
+    point.final_position =
+        Vector2{x, Lerp(a.final_position.y, b.final_position.y, t)};
+    point.previous_final_position =
+        Vector2{x, Lerp(a.previous_final_position.y,
+                        b.previous_final_position.y, t)};
+  }
+
+  m_resolution = resolution;
+  m_background_heights.resize(m_wave_points.size());
+  m_height_prefix.resize(m_wave_points.size() + 1);
+  ResetBlocks();
+  UpdateHeightPrefix();
+  // Impulses gathered for the old columns no longer line up, Sync drops them
+  SyncSurface();
+
+  if (m_gpu != nullptr) {
+    m_gpu->Resample(resolution + 1);
+  }
+
+  m_mesh_dirty = true;
+}
+
+void InteractivePool::SetWaterColor(Color color) {
+  m_water_color = color;
+  m_material.SetColor(m_water_color_uniform, color);
 }
 
-std::vector<float> InteractivePool::normalized_water_color() {
-  return NormalizeColor(m_water_color);
+void InteractivePool::SetFoamColor(Color color) {
+  m_foam_color = color;
+  m_material.SetColor(m_foam_color_uniform, color);
 }
 
 float InteractivePool::GetBackgroundWaveHeightAt(const float &x) {
@@ -63,44 +164,94 @@ float InteractivePool::GetBackgroundWaveHeightAt(const float &x) {
   y = 0;
 
   for (size_t i = 0; i < MAX_BACKGROUND_WAVES; i++) {
-    y += ComputeWave(x, m_total_time, m_waves_parameters[i][0],
-                     m_waves_parameters[i][1], m_waves_parameters[i][2],
-                     m_waves_parameters[i][3]);
+    y += ComputeWave(x, m_waves_parameters[i][0], m_waves_parameters[i][1],
+                     m_wave_phases[i]);
   }
 
   return y;
 }
 
-float InteractivePool::ComputeWave(float x, float t, float amplitude,
-                                   float wave_length, float frequency,
+float InteractivePool::ComputeWave(float x, float amplitude, float wave_length,
                                    float phase) {
   float k;
 
   k = 2 * PI / wave_length;
 
-  return amplitude * sin(k * x - frequency * t + phase) + amplitude;
+  return amplitude * sin(k * x + phase) + amplitude;
 }
 
-float InteractivePool::SampleYFromRange(float min_x, float max_x) {
-  float sample_y;
-  int num_points;
+// Wrapping keeps the phases small, so precision does not decay with uptime.
+void InteractivePool::AdvanceWavePhases(float dt) {
+  for (int i = 0; i < MAX_BACKGROUND_WAVES; i++) {
+    m_wave_phases[i] -= (double)m_waves_parameters[i][2] * dt;
+    m_wave_phases[i] = fmod(m_wave_phases[i], 2 * M_PI);
 
-  sample_y = 0;
-  num_points = 0;
+    if (m_wave_phases[i] < 0) {
+      m_wave_phases[i] += 2 * M_PI;
+    }
+  }
+}
+
+// Wave points are evenly spaced, so sin(k * x + phase) along the surface is a
+// rotation by k * step per point. One sin/cos per wave seeds the recurrence,
+// instead of one sin per wave and point.
+void InteractivePool::EvaluateBackgroundWaves() {
+  size_t count = m_wave_points.size();
+
+  if (count == 0) {
+    return;
+  }
+
+  double step = (double)transform.size.x / m_resolution;
+  double first_x = m_wave_points[0].offset.x;
+
+  for (size_t i = 0; i < count; i++) {
+    m_background_heights[i] = 0;
+  }
+
+  for (int w = 0; w < MAX_BACKGROUND_WAVES; w++) {
+    double amplitude = m_waves_parameters[w][0];
+    double k = 2 * M_PI / m_waves_parameters[w][1];
+    double angle = k * first_x + m_wave_phases[w];
+    double s = sin(angle), c = cos(angle);
+    double step_s = sin(k * step), step_c = cos(k * step);
+    double next_s;
+
+    for (size_t i = 0; i < count; i++) {
+      m_background_heights[i] += amplitude * s + amplitude;
 
-  for (int i = 0; i < m_wave_points.size(); i++) {
-    if (GetCenterPoint().x + m_wave_points[i].final_position.x >= min_x &&
-        GetCenterPoint().x + m_wave_points[i].final_position.x <= max_x) {
-      sample_y += m_wave_points[i].final_position.y;
-      num_points++;
+      next_s = s * step_c + c * step_s;
+      c = c * step_c - s * step_s;
+      s = next_s;
     }
   }
+}
+
+float InteractivePool::SampleYFromRange(float min_x, float max_x) {
+  size_t begin, end;
 
-  if (num_points == 0) {
+  GetPointRange(min_x, max_x, begin, end);
+
+  if (begin >= end) {
     return 0;
   }
 
-  return GetCenterPoint().y + sample_y / num_points;
+  return GetCenterPoint().y +
+         (m_height_prefix[end] - m_height_prefix[begin]) / (end - begin);
+}
+
+void InteractivePool::SampleYFromRanges(const WaterSampleRange *ranges,
+                                        float *sample_ys, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    sample_ys[i] = SampleYFromRange(ranges[i].min_x, ranges[i].max_x);
+  }
+}
+
+void InteractivePool::AddFloatingBodies(const WaterSampleRange *ranges,
+                                        size_t count) {
+  if (m_adaptive) {
+    m_body_ranges.insert(m_body_ranges.end(), ranges, ranges + count);
+  }
 }
 
 Vector2 InteractivePool::GetClosestPointTo(const Vector2 &point) {
@@ -122,45 +273,753 @@ Vector2 InteractivePool::GetClosestPointTo(const Vector2 &point) {
                  GetCenterPoint().y + closest_point.y};
 }
 
+int InteractivePool::AddInteractor(const WaveInteractor &interactor) {
+  m_interactors.push_back(interactor);
+
+  return m_interactors.size() - 1;
+}
+
 void InteractivePool::UpdateWavePoints(float dt) {
-  float force, left_force, right_force;
+  RAIN_PROFILE_ZONE("InteractivePool::UpdateWavePoints");
+
+  m_interactors[MOUSE_INTERACTOR].position = m_platform->GetMousePosition();
+
+  // Wakes and refines around the interactors before they push the points
+  WakeBlocks();
+
+  if (m_adaptive) {
+    AdaptBlocks();
+  }
+
+  ApplyInteractors(dt);
+  EvaluateBackgroundWaves();
+
+  if (m_solver == WaveSolver::Implicit) {
+    IntegrateImplicit(dt);
+  } else {
+    IntegrateExplicit(dt);
+  }
+
+  if (m_adaptive) {
+    InterpolateInactivePoints();
+  }
+
+  UpdateSleepingBlocks(dt);
 
   for (size_t i = 0; i < m_wave_points.size(); i++) {
     WavePoint &wave_point = m_wave_points[i];
 
-    force = 0;
-    force = SPRING_BASELINE_CONSTANT *
-            (wave_point.position.y - wave_point.offset.y);
+    wave_point.previous_final_position = wave_point.final_position;
+    wave_point.final_position.y =
+        wave_point.offset.y + m_background_heights[i];
+  }
+
+  UpdateHeightPrefix();
+}
+
+void InteractivePool::UpdateHeightPrefix() {
+  m_height_prefix[0] = 0;
+
+  for (size_t i = 0; i < m_wave_points.size(); i++) {
+    m_height_prefix[i + 1] =
+        m_height_prefix[i] + m_wave_points[i].final_position.y;
+  }
+}
+
+// Neighbors are read in place, so a point sees the previous one after its
+// update and the result depends on the iteration order
+void InteractivePool::IntegrateExplicit(float dt) {
+  float force, left_force, right_force;
+  const std::vector<float> &impulses = m_surface.impulses();
+  size_t begin, end;
+
+  for (size_t block = 0; block < m_block_levels.size(); block++) {
+    if (m_block_asleep[block]) {
+      continue;
+    }
+
+    GetBlockRange(block, begin, end);
+
+    // The last block also owns the last point
+    if (block + 1 == m_block_levels.size()) {
+      end++;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+      WavePoint &wave_point = m_wave_points[i];
+
+      wave_point.velocity.y += impulses[i] * IMPACT_RESPONSE;
+
+      force = 0;
+      force = SPRING_BASELINE_CONSTANT *
+              (wave_point.position.y - wave_point.offset.y);
+
+      right_force = left_force = 0;
+
+      if (i == 0) {
+        right_force = SPRING_CONSTANT *
+                      (m_wave_points[i + 1].offset.y - wave_point.offset.y);
+      } else if (i == m_wave_points.size() - 1) {
+        left_force = SPRING_CONSTANT *
+                     (m_wave_points[i - 1].offset.y - wave_point.offset.y);
+      } else {
+        right_force = SPRING_CONSTANT *
+                      (m_wave_points[i + 1].offset.y - wave_point.offset.y);
+        left_force = SPRING_CONSTANT *
+                     (m_wave_points[i - 1].offset.y - wave_point.offset.y);
+      }
+
+      force += right_force + left_force;
+
+      wave_point.velocity.y += force * dt;
+      wave_point.velocity.y *= powf(1 - SPRING_DAMPING_CONSTANT,
+                                    dt * SPRING_DAMPING_REFERENCE_RATE);
+
+      wave_point.offset.y += wave_point.velocity.y * dt;
+    }
+  }
+}
+
+// Backward Euler on the spring chain: the forces are taken at the end of the
+// step, which gives the tridiagonal system
+//   (1 + dt^2 (kb + k (l_i + r_i))) u_i - dt^2 k (l_i u_i-1 + r_i u_i+1)
+//     = u_i + dt v_i + dt^2 kb rest_i
+// over the simulated points. l_i and r_i weigh the neighbors by their
+// distance in segments, so the chain approximates the same wave equation at
+// any spacing; evenly spaced points have l_i = r_i = 1, and 0 for a missing
+// neighbor. The system is diagonally dominant, so the Thomas algorithm solves
+// it without pivoting in one sweep each way. Every run of awake blocks is
+// solved on its own, with the sleeping points around it held at rest.
+void InteractivePool::IntegrateImplicit(float dt) {
+  size_t blocks = m_block_levels.size();
+
+  if (m_active_points.empty() || dt <= 0) {
+    return;
+  }
+
+  GatherImpulses();
+  m_solver_upper.resize(m_active_points.size());
+  m_solver_rhs.resize(m_active_points.size());
+
+  for (size_t block = 0; block < blocks;) {
+    if (m_block_asleep[block]) {
+      block++;
+      continue;
+    }
+
+    size_t run_end = block;
+
+    while (run_end < blocks && !m_block_asleep[run_end]) {
+      run_end++;
+    }
+
+    SolveImplicitRun(m_block_first_active[block],
+                     m_block_first_active[run_end], dt);
+    block = run_end;
+  }
+}
+
+// Solves the active points [begin, end), see IntegrateImplicit
+void InteractivePool::SolveImplicitRun(size_t begin, size_t end, float dt) {
+  size_t count = m_active_points.size();
+  float coupling = dt * dt * SPRING_CONSTANT;
+  float baseline = dt * dt * SPRING_BASELINE_CONSTANT;
+  float damping =
+      powf(1 - SPRING_DAMPING_CONSTANT, dt * SPRING_DAMPING_REFERENCE_RATE);
+
+  for (size_t k = begin; k < end; k++) {
+    WavePoint &wave_point = m_wave_points[m_active_points[k]];
+    float left_gap =
+        k > 0 ? m_active_points[k] - m_active_points[k - 1] : 0.0f;
+    float right_gap =
+        k + 1 < count ? m_active_points[k + 1] - m_active_points[k] : 0.0f;
+    float left = 0, right = 0;
+    float diagonal, rhs;
+
+    if (left_gap > 0 && right_gap > 0) {
+      left = 2 / (left_gap * (left_gap + right_gap));
+      right = 2 / (right_gap * (left_gap + right_gap));
+    } else if (left_gap > 0) {
+      left = 1 / (left_gap * left_gap);
+    } else if (right_gap > 0) {
+      right = 1 / (right_gap * right_gap);
+    }
+
+    diagonal = 1 + baseline + coupling * (left + right);
+    wave_point.velocity.y += m_active_impulses[k] * IMPACT_RESPONSE;
 
-    right_force = left_force = 0;
+    rhs = wave_point.offset.y + dt * wave_point.velocity.y +
+          baseline * wave_point.position.y;
+
+    if (k > begin) {
+      diagonal += coupling * left * m_solver_upper[k - 1];
+      rhs += coupling * left * m_solver_rhs[k - 1];
+    } else if (left > 0) {
+      rhs += coupling * left * m_wave_points[m_active_points[k - 1]].offset.y;
+    }
 
-    if (i == 0) {
-      right_force = SPRING_CONSTANT *
-                    (m_wave_points[i + 1].offset.y - wave_point.offset.y);
-    } else if (i == m_wave_points.size() - 1) {
-      left_force = SPRING_CONSTANT *
-                   (m_wave_points[i - 1].offset.y - wave_point.offset.y);
+    if (k + 1 < end) {
+      m_solver_upper[k] = -coupling * right / diagonal;
     } else {
-      right_force = SPRING_CONSTANT *
-                    (m_wave_points[i + 1].offset.y - wave_point.offset.y);
-      left_force = SPRING_CONSTANT *
-                   (m_wave_points[i - 1].offset.y - wave_point.offset.y);
+      m_solver_upper[k] = 0;
+
+      if (right > 0) {
+        rhs +=
+            coupling * right * m_wave_points[m_active_points[k + 1]].offset.y;
+      }
     }
 
-    force += right_force + left_force;
+    m_solver_rhs[k] = rhs / diagonal;
+  }
+
+  float next = 0;
+
+  for (size_t k = end; k-- > begin;) {
+    WavePoint &wave_point = m_wave_points[m_active_points[k]];
+    float offset = m_solver_rhs[k] - m_solver_upper[k] * next;
+
+    wave_point.velocity.y = (offset - wave_point.offset.y) / dt * damping;
+    wave_point.offset.y = offset;
+    next = offset;
+  }
+}
+
+void InteractivePool::ResetBlocks() {
+  size_t segments = m_wave_points.empty() ? 0 : m_wave_points.size() - 1;
+  size_t blocks = (segments + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  m_block_levels.assign(blocks, 0);
+  m_next_block_levels.assign(blocks, 0);
+  m_block_asleep.assign(blocks, false);
+  m_block_calm_time.assign(blocks, 0);
+  m_body_ranges.clear();
+  RebuildActivePoints();
+  m_simulated_points = m_active_points.size();
+}
 
-    if (CountPointsUnderInfluence() > MIN_POINTS_UNDER_MOUSE) {
-      ApplyWaveInfluenceForce(wave_point, dt);
+// Block b covers the points [b * BLOCK_SIZE, (b + 1) * BLOCK_SIZE], so
+// neighboring blocks share their boundary point. It belongs to the later
+// block, and every level simulates it.
+void InteractivePool::GetBlockRange(size_t block, size_t &begin,
+                                    size_t &end) {
+  begin = block * BLOCK_SIZE;
+  end = std::min(begin + BLOCK_SIZE, m_wave_points.size() - 1);
+}
+
+// Each point stands for the mass of the segments around it that interpolate
+// from it: half of every neighboring gap, plus half a point at the ends of the
+// chain. Evenly spaced points all weigh 1.
+void InteractivePool::RebuildActivePoints() {
+  size_t count = m_wave_points.size();
+  size_t begin, end;
+
+  m_active_points.clear();
+  m_active_masses.clear();
+  m_block_first_active.clear();
+
+  if (count == 0) {
+    return;
+  }
+
+  for (size_t block = 0; block < m_block_levels.size(); block++) {
+    size_t stride = (size_t)1 << m_block_levels[block];
+
+    GetBlockRange(block, begin, end);
+    m_block_first_active.push_back(m_active_points.size());
+
+    for (size_t i = begin; i < end; i += stride) {
+      m_active_points.push_back(i);
     }
+  }
 
-    wave_point.velocity.y += force * dt;
-    wave_point.velocity.y -= wave_point.velocity.y * SPRING_DAMPING_CONSTANT;
+  m_active_points.push_back(count - 1);
+  m_block_first_active.push_back(m_active_points.size());
+
+  for (size_t k = 0; k < m_active_points.size(); k++) {
+    float left_gap =
+        k > 0 ? m_active_points[k] - m_active_points[k - 1] : 1.0f;
+    float right_gap = k + 1 < m_active_points.size()
+                          ? m_active_points[k + 1] - m_active_points[k]
+                          : 1.0f;
+
+    m_active_masses.push_back((left_gap + right_gap) / 2);
+  }
+}
+
+// Every block moves at most one level per step: it refines where its points
+// stray from the lines between their neighbors, coarsens where the points it
+// would drop are within COARSEN_ERROR of them, and goes straight to level 0
+// under an interactor. Floating bodies only sample the mean height under
+// them, so they hold blocks at MAX_BODY_LEVEL or finer. Coarsening is only
+// considered every COARSEN_INTERVAL steps, so blocks on the edge of the
+// thresholds do not rebuild the active points every step.
+//
+// Points a refined block starts simulating already hold the state
+// interpolated from their neighbors, and points a coarsened block drops are
+// interpolated from then on. Either changes the mass every point stands for,
+// so the velocities inside the changed blocks are shifted by a common amount
+// that keeps the total momentum of the surface what it was before.
+void InteractivePool::AdaptBlocks() {
+  RAIN_PROFILE_ZONE("InteractivePool::AdaptBlocks");
+
+  size_t blocks = m_block_levels.size();
+  size_t first, last;
+  bool changed = false;
+  bool coarsen = ++m_adapt_steps % COARSEN_INTERVAL == 0;
+
+  m_block_max_levels.assign(blocks, (int)MAX_ADAPTIVE_LEVEL);
+
+  for (const WaterSampleRange &range : m_body_ranges) {
+    GetBlockSpan(range.min_x, range.max_x, first, last);
+
+    for (size_t block = first; block < last; block++) {
+      m_block_max_levels[block] =
+          std::min(m_block_max_levels[block], (int)MAX_BODY_LEVEL);
+    }
+  }
+
+  for (const WaveInteractor &interactor : m_interactors) {
+    GetBlockSpan(interactor.position.x - interactor.radius,
+                 interactor.position.x + interactor.radius, first, last);
+
+    for (size_t block = first; block < last; block++) {
+      if (IsBlockNearInteractor(block)) {
+        m_block_max_levels[block] = 0;
+      }
+    }
+  }
+
+  for (size_t block = 0; block < blocks; block++) {
+    m_next_block_levels[block] = GetBlockTargetLevel(block, coarsen);
+    changed |= m_next_block_levels[block] != m_block_levels[block];
+  }
+
+  m_body_ranges.clear();
+
+  if (!changed) {
+    return;
+  }
+
+  double momentum = 0;
+
+  for (size_t k = 0; k < m_active_points.size(); k++) {
+    momentum += m_active_masses[k] *
+                m_wave_points[m_active_points[k]].velocity.y;
+  }
+
+  std::vector<int> &previous_levels = m_next_block_levels;
+
+  m_block_levels.swap(previous_levels);
+  RebuildActivePoints();
+
+  double changed_mass = 0;
+
+  for (size_t k = 0; k < m_active_points.size(); k++) {
+    size_t i = m_active_points[k];
+    size_t block = i / BLOCK_SIZE;
+
+    momentum -= m_active_masses[k] * m_wave_points[i].velocity.y;
+
+    if (i % BLOCK_SIZE != 0 &&
+        m_block_levels[block] != previous_levels[block]) {
+      changed_mass += m_active_masses[k];
+    }
+  }
+
+  if (changed_mass <= 0) {
+    return;
+  }
+
+  float correction = momentum / changed_mass;
+
+  for (size_t i : m_active_points) {
+    size_t block = i / BLOCK_SIZE;
+
+    if (i % BLOCK_SIZE != 0 &&
+        m_block_levels[block] != previous_levels[block]) {
+      m_wave_points[i].velocity.y += correction;
+    }
+  }
+}
+
+int InteractivePool::GetBlockTargetLevel(size_t block, bool coarsen) {
+  size_t begin, end;
+  int level = m_block_levels[block];
+  size_t stride = (size_t)1 << level;
+
+  // Sleeping points sit at rest, there is nothing to resolve
+  if (m_block_asleep[block]) {
+    return level;
+  }
+
+  if (level >= m_block_max_levels[block]) {
+    return m_block_max_levels[block];
+  }
+
+  GetBlockRange(block, begin, end);
+
+  if (GetInterpolationError(begin + stride, end, stride, stride) >
+      REFINE_ERROR) {
+    return std::max(level - 1, 0);
+  }
+
+  // The points the next level drops must follow the line between their
+  // neighbors, and the points it keeps must not ask to refine right away. A
+  // block also keeps at least one point between its boundaries, so a change
+  // of level always has a velocity to correct.
+  if (coarsen && 2 * stride < end - begin &&
+      GetInterpolationError(begin + stride, end, stride, 2 * stride) <
+          COARSEN_ERROR &&
+      GetInterpolationError(begin + 2 * stride, end, 2 * stride,
+                            2 * stride) <= REFINE_ERROR) {
+    return level + 1;
+  }
+
+  return level;
+}
+
+// Blocks [first, last) overlapping the screen x range
+void InteractivePool::GetBlockSpan(float min_x, float max_x, size_t &first,
+                                   size_t &last) {
+  float block_width = transform.size.x / m_resolution * BLOCK_SIZE;
+  float blocks = m_block_levels.size();
+
+  first = (size_t)std::clamp(
+      floorf((min_x - transform.position.x) / block_width), 0.0f, blocks);
+  last = (size_t)std::clamp(
+      floorf((max_x - transform.position.x) / block_width) + 1, 0.0f, blocks);
+}
+
+bool InteractivePool::IsBlockNearInteractor(size_t block) {
+  size_t begin, end;
+
+  GetBlockRange(block, begin, end);
+
+  float step = transform.size.x / m_resolution;
+  float min_x = transform.position.x + step * begin;
+  float max_x = transform.position.x + step * end;
+  float surface_y = GetCenterPoint().y + m_wave_points[begin].final_position.y;
+
+  for (const WaveInteractor &interactor : m_interactors) {
+    if (interactor.position.x + interactor.radius >= min_x &&
+        interactor.position.x - interactor.radius <= max_x &&
+        fabsf(interactor.position.y - surface_y) <=
+            interactor.radius + MAX_INFLUENCE_DIST) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Largest distance, in pixels, between the points first, first + stride, ...
+// up to end and the line through their neighbors spacing points away on both
+// sides, i.e. how far off interpolating them from those neighbors would be.
+// Velocities count as the offset they build up over ERROR_LOOKAHEAD, so
+// blocks refine before a ripple arrives.
+float InteractivePool::GetInterpolationError(size_t first, size_t end,
+                                             size_t spacing, size_t stride) {
+  float error = 0;
+
+  for (size_t i = first; i + spacing <= end; i += stride) {
+    const WavePoint &left = m_wave_points[i - spacing];
+    const WavePoint &point = m_wave_points[i];
+    const WavePoint &right = m_wave_points[i + spacing];
+    float offset = point.offset.y - (left.offset.y + right.offset.y) / 2;
+    float velocity =
+        point.velocity.y - (left.velocity.y + right.velocity.y) / 2;
+
+    error = std::max(error, fabsf(offset + velocity * ERROR_LOOKAHEAD));
+  }
+
+  return error;
+}
+
+// Spreads the impulse of every awake point onto the two simulated points
+// around it by its interpolation weights, divided by their mass so the
+// momentum added matches the impulse
+void InteractivePool::GatherImpulses() {
+  const std::vector<float> &impulses = m_surface.impulses();
+  size_t count = m_active_points.size();
+
+  m_active_impulses.assign(count, 0);
+
+  for (size_t block = 0; block < m_block_levels.size(); block++) {
+    if (m_block_asleep[block]) {
+      continue;
+    }
+
+    for (size_t k = m_block_first_active[block];
+         k < m_block_first_active[block + 1] && k + 1 < count; k++) {
+      size_t begin = m_active_points[k];
+      size_t end = m_active_points[k + 1];
+      float gap = end - begin;
+
+      for (size_t i = begin; i < end; i++) {
+        if (impulses[i] == 0) {
+          continue;
+        }
+
+        float t = (i - begin) / gap;
+
+        m_active_impulses[k] += impulses[i] * (1 - t) / m_active_masses[k];
+        m_active_impulses[k + 1] += impulses[i] * t / m_active_masses[k + 1];
+      }
+    }
+  }
+
+  if (count > 0) {
+    m_active_impulses[count - 1] +=
+        impulses[m_active_points[count - 1]] / m_active_masses[count - 1];
+  }
+}
 
-    wave_point.offset.y += wave_point.velocity.y * dt;
+void InteractivePool::InterpolateInactivePoints() {
+  size_t count = m_active_points.size();
 
+  for (size_t block = 0; block < m_block_levels.size(); block++) {
+    if (m_block_asleep[block]) {
+      continue;
+    }
+
+    for (size_t k = m_block_first_active[block];
+         k < m_block_first_active[block + 1] && k + 1 < count; k++) {
+      size_t begin = m_active_points[k];
+      size_t end = m_active_points[k + 1];
+      const WavePoint &a = m_wave_points[begin];
+      const WavePoint &b = m_wave_points[end];
+      float gap = end - begin;
+
+      for (size_t i = begin + 1; i < end; i++) {
+        float t = (i - begin) / gap;
+
+        m_wave_points[i].offset.y = Lerp(a.offset.y, b.offset.y, t);
+        m_wave_points[i].velocity.y = Lerp(a.velocity.y, b.velocity.y, t);
+      }
+    }
+  }
+}
+
+// Wakes the sleeping blocks an interactor reaches or an impulse pushes past
+// SLEEP_VELOCITY. Lighter impulses would leave the block calm, so they are
+// dropped.
+void InteractivePool::WakeBlocks() {
+  const std::vector<float> &impulses = m_surface.impulses();
+  size_t begin, end;
+
+  for (size_t block = 0; block < m_block_levels.size(); block++) {
+    if (!m_block_asleep[block]) {
+      continue;
+    }
+
+    bool wake = IsBlockNearInteractor(block);
+
+    GetBlockRange(block, begin, end);
+
+    for (size_t i = begin; i <= end && !wake; i++) {
+      wake = fabsf(impulses[i]) * IMPACT_RESPONSE > SLEEP_VELOCITY;
+    }
+
+    if (wake) {
+      m_block_asleep[block] = false;
+      m_block_calm_time[block] = 0;
+    }
+  }
+}
+
+// Puts the blocks that stayed calm for SLEEP_DELAY to sleep, holding their
+// points at rest, and wakes the neighbors of awake blocks whose motion reaches
+// the points next to them
+void InteractivePool::UpdateSleepingBlocks(float dt) {
+  size_t blocks = m_block_levels.size();
+  size_t begin, end;
+
+  auto is_calm = [](const WavePoint &wave_point) {
+    return fabsf(wave_point.offset.y - wave_point.position.y) <=
+               SLEEP_OFFSET &&
+           fabsf(wave_point.velocity.y) <= SLEEP_VELOCITY;
+  };
+
+  m_simulated_points = 0;
+
+  for (size_t block = 0; block < blocks; block++) {
+    if (m_block_asleep[block]) {
+      continue;
+    }
+
+    GetBlockRange(block, begin, end);
+    m_simulated_points +=
+        m_block_first_active[block + 1] - m_block_first_active[block];
+
+    if (block > 0 && !is_calm(m_wave_points[begin])) {
+      m_block_asleep[block - 1] = false;
+      m_block_calm_time[block - 1] = 0;
+    }
+
+    if (block + 1 < blocks && end > begin &&
+        !is_calm(m_wave_points[end - 1])) {
+      m_block_asleep[block + 1] = false;
+      m_block_calm_time[block + 1] = 0;
+    }
+
+    bool calm = true;
+
+    for (size_t i = begin; i <= end && calm; i++) {
+      calm = is_calm(m_wave_points[i]);
+    }
+
+    m_block_calm_time[block] = calm ? m_block_calm_time[block] + dt : 0;
+
+    if (m_block_calm_time[block] < SLEEP_DELAY) {
+      continue;
+    }
+
+    // The last block also owns the last point
+    if (block + 1 == blocks) {
+      end++;
+    }
+
+    for (size_t i = begin; i < end; i++) {
+      m_wave_points[i].offset.y = m_wave_points[i].position.y;
+      m_wave_points[i].velocity.y = 0;
+    }
+
+    m_block_asleep[block] = true;
+  }
+}
+
+void InteractivePool::LoadGpuSimulation() {
+  // Without a window there is no GL context, nor a mesh, to simulate in
+  if (m_vao != 0) {
+    m_gpu = std::make_unique<GpuWaterSim>(m_mesh_capacity);
+
+    if (m_gpu->IsSupported()) {
+      std::vector<Vector4> points;
+
+      for (const WavePoint &wave_point : m_wave_points) {
+        points.push_back(Vector4{wave_point.offset.y, wave_point.velocity.y,
+                                 wave_point.final_position.y, 1});
+      }
+
+      m_gpu->Upload(points);
+      m_gpu_impulses.reserve(m_mesh_capacity);
+      m_gpu_readback.reserve(GpuWaterSim::READBACK_WIDTH);
+
+      return;
+    }
+
+    m_gpu.reset();
+  }
+
+  TraceLog(LOG_WARNING, "POOL: GPU water is not available, using the "
+                        "implicit solver");
+  m_solver = WaveSolver::Implicit;
+}
+
+GpuWaterStep InteractivePool::GetGpuStep(float dt) {
+  static_assert(MAX_BACKGROUND_WAVES <= 4, "waves are packed in a vec4");
+
+  float amplitudes[4] = {0, 0, 0, 0};
+  float wave_numbers[4] = {0, 0, 0, 0};
+  float phases[4] = {0, 0, 0, 0};
+
+  for (int i = 0; i < MAX_BACKGROUND_WAVES; i++) {
+    amplitudes[i] = m_waves_parameters[i][0];
+    wave_numbers[i] = 2 * PI / m_waves_parameters[i][1];
+    phases[i] = m_wave_phases[i];
+  }
+
+  return GpuWaterStep{
+      .dt = dt,
+      .spring_constant = SPRING_CONSTANT,
+      .baseline_constant = SPRING_BASELINE_CONSTANT,
+      .damping = powf(1 - SPRING_DAMPING_CONSTANT,
+                      dt * SPRING_DAMPING_REFERENCE_RATE),
+      .rest = m_wave_points[0].position.y,
+      .center = GetCenterPoint(),
+      .first_x = m_wave_points[0].offset.x,
+      .column_width = transform.size.x / m_resolution,
+      .wave_amplitudes = Vector4{amplitudes[0], amplitudes[1], amplitudes[2],
+                                 amplitudes[3]},
+      .wave_numbers = Vector4{wave_numbers[0], wave_numbers[1],
+                              wave_numbers[2], wave_numbers[3]},
+      .wave_phases = Vector4{phases[0], phases[1], phases[2], phases[3]}};
+}
+
+void InteractivePool::RunGpuSteps() {
+  if (m_gpu == nullptr) {
+    return;
+  }
+
+  RAIN_PROFILE_ZONE("InteractivePool::RunGpuSteps");
+
+  const std::vector<float> &impulses = m_surface.impulses();
+
+  m_gpu_impulses.resize(impulses.size());
+
+  for (size_t i = 0; i < impulses.size(); i++) {
+    m_gpu_impulses[i] = impulses[i] * IMPACT_RESPONSE;
+  }
+
+  for (float dt : m_gpu_steps) {
+    size_t begin, end;
+
+    m_gpu_splats.clear();
+
+    for (const WaveInteractor &interactor : m_interactors) {
+      GetInteractorRange(interactor, begin, end);
+      m_gpu_splats.push_back(GpuWaterSplat{
+          (int)begin, (int)end, interactor.position, interactor.radius,
+          interactor.force * dt, MAX_INFLUENCE_DIST});
+    }
+
+    m_gpu->Step(GetGpuStep(dt), m_gpu_impulses.data(), m_gpu_splats.data(),
+                m_gpu_splats.size());
+
+    // The impulses were gathered once for all queued steps
+    std::fill(m_gpu_impulses.begin(), m_gpu_impulses.end(), 0);
+  }
+
+  m_gpu_steps.clear();
+  m_gpu->RequestReadback();
+
+  if (m_gpu->PollReadback(m_gpu_readback)) {
+    ApplyGpuReadback();
+  }
+}
+
+// Spreads the downsampled heights over the CPU points, which only serve
+// collisions and buoyancy while the GPU solver runs
+void InteractivePool::ApplyGpuReadback() {
+  size_t count = m_wave_points.size();
+  size_t last = m_gpu_readback.size() - 1;
+
+  for (size_t i = 0; i < count; i++) {
+    float source = count > 1 ? (float)i * last / (count - 1) : 0;
+    size_t left = std::min((size_t)source, last);
+    size_t right = std::min(left + 1, last);
+    WavePoint &wave_point = m_wave_points[i];
+
+    wave_point.previous_final_position = wave_point.final_position;
     wave_point.final_position.y =
-        wave_point.offset.y + GetBackgroundWaveHeightAt(wave_point.offset.x);
+        Lerp(m_gpu_readback[left], m_gpu_readback[right], source - left);
+  }
+
+  UpdateHeightPrefix();
+}
+
+void InteractivePool::SyncSurface() {
+  Vector2 center = GetCenterPoint();
+  float step = transform.size.x / m_resolution;
+
+  m_surface_ys.resize(m_wave_points.size());
+
+  for (size_t i = 0; i < m_wave_points.size(); i++) {
+    m_surface_ys[i] = center.y + m_wave_points[i].final_position.y;
   }
+
+  m_surface.Sync(transform.position.x, step, m_surface_ys.data(),
+                 m_surface_ys.size());
 }
 
 Vector2 InteractivePool::GetCenterPoint() {
@@ -168,30 +1027,312 @@ Vector2 InteractivePool::GetCenterPoint() {
                  transform.position.y + transform.size.y / 2};
 }
 
-void InteractivePool::BindShaderValue(const char *name, void *value,
-                                      int uniformType) {
-  int loc = GetShaderLocation(m_shader, name);
-  SetShaderValue(m_shader, loc, value, uniformType);
+Transform InteractivePool::GetRenderTransform() {
+  Transform render_transform = transform;
+
+  render_transform.position = Vector2Lerp(m_previous_transform.position,
+                                          transform.position, render_alpha);
+  render_transform.size =
+      Vector2Lerp(m_previous_transform.size, transform.size, render_alpha);
+
+  return render_transform;
+}
+
+void InteractivePool::GetRenderSurfaceRange(const Transform &render_transform,
+                                            float &min_y, float &max_y) {
+  float center_y = render_transform.position.y + render_transform.size.y / 2;
+
+  min_y = INFINITY;
+  max_y = -INFINITY;
+
+  for (const WavePoint &wave_point : m_wave_points) {
+    float y = center_y + Lerp(wave_point.previous_final_position.y,
+                              wave_point.final_position.y, render_alpha);
+
+    min_y = std::min(min_y, y);
+    max_y = std::max(max_y, y);
+  }
+
+  if (m_gpu != nullptr) {
+    min_y -= GPU_BOUNDS_MARGIN;
+    max_y += GPU_BOUNDS_MARGIN;
+  }
+}
+
+Rectangle InteractivePool::GetDrawBounds() {
+  if (m_wave_points.empty()) {
+    return Rectangle{};
+  }
+
+  Transform render_transform = GetRenderTransform();
+  float bottom_y = render_transform.position.y + render_transform.size.y;
+  float min_y;
+  float max_y;
+
+  GetRenderSurfaceRange(render_transform, min_y, max_y);
+
+  return Rectangle{render_transform.position.x, min_y,
+                   render_transform.size.x, bottom_y - min_y};
+}
+
+Rectangle InteractivePool::GetDamageBounds() {
+  if (m_wave_points.empty()) {
+    return Rectangle{};
+  }
+
+  Transform render_transform = GetRenderTransform();
+  float center_x = render_transform.position.x + render_transform.size.x / 2;
+  float bottom_y = render_transform.position.y + render_transform.size.y;
+
+  bool moved = center_x != m_damage_center_x ||
+               bottom_y != m_damage_bottom_y ||
+               m_resolution != m_damage_resolution;
+
+  m_damage_center_x = center_x;
+  m_damage_bottom_y = bottom_y;
+  m_damage_resolution = m_resolution;
+
+  if (moved) {
+    return GetDrawBounds();
+  }
+
+  float min_y;
+  float max_y;
+
+  GetRenderSurfaceRange(render_transform, min_y, max_y);
+
+  return Rectangle{render_transform.position.x, min_y,
+                   render_transform.size.x, max_y - min_y};
+}
+
+void InteractivePool::Unload() {
+  m_gpu.reset();
+
+  if (m_vao == 0) {
+    return;
+  }
+
+  rlUnloadVertexArray(m_vao);
+  rlUnloadVertexBuffer(m_x_vbo);
+  rlUnloadVertexBuffer(m_y_vbo);
+  rlUnloadVertexBuffer(m_texcoord_vbo);
+  rlUnloadVertexBuffer(m_ebo);
+
+  m_vao = m_x_vbo = m_y_vbo = m_texcoord_vbo = m_ebo = 0;
+}
+
+// The water is a height field, so the topology never changes: column i is
+// the two triangles between points i and i + 1 and the pool bottom below
+// them.
+void InteractivePool::LoadRenderData() {
+  int capacity = m_max_resolution + 1;
+
+  if (capacity < 2 || 2 * capacity > MAX_MESH_VERTICES) {
+    TraceLog(LOG_WARNING,
+             "POOL: %d wave points do not fit the water mesh, at most %d do",
+             capacity, MAX_MESH_VERTICES / 2);
+    return;
+  }
+
+  // A triangle list rather than a strip: rlgl draws vertex arrays only as
+  // triangles. A resolution still draws a prefix, 6 indices per column.
+  std::vector<unsigned short> indices;
+
+  for (int i = 0; i < capacity - 1; i++) {
+    indices.insert(indices.end(),
+                   {(unsigned short)i, (unsigned short)(capacity + i),
+                    (unsigned short)(i + 1), (unsigned short)(i + 1),
+                    (unsigned short)(capacity + i),
+                    (unsigned short)(capacity + i + 1)});
+  }
+
+  LoadMaterial();
+
+  m_mesh_capacity = capacity;
+  m_vertex_xs.assign(2 * capacity, 0);
+  m_vertex_ys.assign(2 * capacity, 0);
+  m_tex_coords.assign(2 * capacity, Vector2{0, 0});
+
+  int x_loc = GetShaderLocationAttrib(m_shader, "vertexX");
+  int y_loc = GetShaderLocationAttrib(m_shader, "vertexY");
+  int texcoord_loc = m_shader.locs[SHADER_LOC_VERTEX_TEXCOORD01];
+
+  m_vao = rlLoadVertexArray();
+  rlEnableVertexArray(m_vao);
+
+  m_x_vbo = rlLoadVertexBuffer(m_vertex_xs.data(),
+                               m_vertex_xs.size() * sizeof(float), true);
+  rlSetVertexAttribute(x_loc, 1, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(x_loc);
+
+  m_y_vbo = rlLoadVertexBuffer(m_vertex_ys.data(),
+                               m_vertex_ys.size() * sizeof(float), true);
+  rlSetVertexAttribute(y_loc, 1, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(y_loc);
+
+  m_texcoord_vbo = rlLoadVertexBuffer(
+      m_tex_coords.data(), m_tex_coords.size() * sizeof(Vector2), true);
+  rlSetVertexAttribute(texcoord_loc, 2, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(texcoord_loc);
+
+  m_ebo = rlLoadVertexBufferElement(
+      indices.data(), indices.size() * sizeof(unsigned short), false);
+
+  rlDisableVertexArray();
+
+  // Make the first UploadSurface write the x, bottom and texcoord buffers
+  m_mesh_dirty = true;
+}
+
+// Texture coordinates span the active points, which only change with the
+// resolution.
+void InteractivePool::UpdateTexCoords() {
+  size_t count = m_wave_points.size();
+  float tex_step = 1.0f / (count - 1);
+
+  for (size_t i = 0; i < count; i++) {
+    m_tex_coords[i] = Vector2{tex_step * i, 0};
+    m_tex_coords[m_mesh_capacity + i] = Vector2{tex_step * i, 1};
+  }
+
+  rlUpdateVertexBuffer(m_texcoord_vbo, m_tex_coords.data(),
+                       m_tex_coords.size() * sizeof(Vector2), 0);
+}
+
+void InteractivePool::LoadMaterial() {
+  m_mvp_uniform = m_material.AddUniform(m_shader.locs[SHADER_LOC_MATRIX_MVP],
+                                        Material::UNIFORM_MATRIX);
+  m_water_color_uniform =
+      m_material.AddUniform("waterColor", SHADER_UNIFORM_VEC4);
+  m_foam_color_uniform =
+      m_material.AddUniform("foamColor", SHADER_UNIFORM_VEC4);
+
+  m_material.SetFloat(m_material.AddUniform("foamWidth", SHADER_UNIFORM_FLOAT),
+                      m_foam_width);
+  // The texture always goes to slot 0, so the sampler is set once
+  m_material.SetInt(m_material.AddUniform(m_shader.locs[SHADER_LOC_MAP_ALBEDO],
+                                          SHADER_UNIFORM_INT),
+                    0);
+
+  // Heights of the GPU solver go to slots 1 and 2
+  m_gpu_heights_uniform =
+      m_material.AddUniform("gpuHeights", SHADER_UNIFORM_INT);
+  m_center_y_uniform = m_material.AddUniform("centerY", SHADER_UNIFORM_FLOAT);
+  m_render_alpha_uniform =
+      m_material.AddUniform("renderAlpha", SHADER_UNIFORM_FLOAT);
+  m_material.SetInt(m_gpu_heights_uniform, 0);
+  m_material.SetInt(m_material.AddUniform("heights", SHADER_UNIFORM_INT), 1);
+  m_material.SetInt(
+      m_material.AddUniform("previousHeights", SHADER_UNIFORM_INT), 2);
+  m_material.SetInt(m_material.AddUniform("meshCapacity", SHADER_UNIFORM_INT),
+                    m_max_resolution + 1);
+
+  SetWaterColor(m_water_color);
+  SetFoamColor(m_foam_color);
+}
+
+void InteractivePool::UploadSurface(const Transform &render_transform) {
+  size_t count = m_wave_points.size();
+  size_t capacity = m_mesh_capacity;
+  Vector2 center = {render_transform.position.x + render_transform.size.x / 2,
+                    render_transform.position.y + render_transform.size.y / 2};
+  float bottom_y = render_transform.position.y + render_transform.size.y;
+
+  if (m_mesh_dirty) {
+    UpdateTexCoords();
+
+    m_uploaded_center_x = NAN;
+    m_uploaded_bottom_y = NAN;
+    m_mesh_dirty = false;
+  }
+
+  if (center.x != m_uploaded_center_x) {
+    for (size_t i = 0; i < count; i++) {
+      m_vertex_xs[i] = m_vertex_xs[capacity + i] =
+          center.x + m_wave_points[i].offset.x;
+    }
+
+    rlUpdateVertexBuffer(m_x_vbo, m_vertex_xs.data(),
+                         m_vertex_xs.size() * sizeof(float), 0);
+    m_uploaded_center_x = center.x;
+  }
+
+  if (bottom_y != m_uploaded_bottom_y) {
+    for (size_t i = 0; i < count; i++) {
+      m_vertex_ys[capacity + i] = bottom_y;
+    }
+
+    rlUpdateVertexBuffer(m_y_vbo, m_vertex_ys.data() + capacity,
+                         count * sizeof(float), capacity * sizeof(float));
+    m_uploaded_bottom_y = bottom_y;
+  }
+
+  // The GPU solver's heights are read by the vertex shader
+  if (m_gpu != nullptr) {
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    m_vertex_ys[i] = center.y + Lerp(m_wave_points[i].previous_final_position.y,
+                                     m_wave_points[i].final_position.y,
+                                     render_alpha);
+  }
+
+  rlUpdateVertexBuffer(m_y_vbo, m_vertex_ys.data(), count * sizeof(float), 0);
 }
 
 void InteractivePool::DrawWave() {
-  WaveRenderData wave_data = GenerateWaveRenderData();
+  RAIN_PROFILE_ZONE("InteractivePool::DrawWave");
+
+  if (m_vao == 0) {
+    return;
+  }
+
+  Transform render_transform = GetRenderTransform();
+
+  m_material.SetMatrix(m_mvp_uniform, MatrixMultiply(rlGetMatrixModelview(),
+                                                     rlGetMatrixProjection()));
+
+  if (m_gpu != nullptr) {
+    m_material.SetInt(m_gpu_heights_uniform, 1);
+    m_material.SetFloat(m_center_y_uniform, render_transform.position.y +
+                                                render_transform.size.y / 2);
+    m_material.SetFloat(m_render_alpha_uniform, render_alpha);
+  }
 
-  BeginShaderMode(m_shader);
+  // Flush whatever rlgl has batched so far, the mesh is drawn directly
+  rlDrawRenderBatchActive();
 
-  BindShaderValue("waterColor", normalized_water_color().data(),
-                  SHADER_UNIFORM_VEC4);
-  BindShaderValue("foamColor", normalized_foam_color().data(),
-                  SHADER_UNIFORM_VEC4);
-  BindShaderValue("foamWidth", &m_foam_width, SHADER_UNIFORM_FLOAT);
+  m_material.Bind();
 
-  DrawPolygon(m_texture,
-              Vector2{transform.position.x + transform.size.x / 2,
-                      transform.position.y + transform.size.y / 2},
-              wave_data.vertices.data(), wave_data.tex_coords.data(),
-              wave_data.vertices.size(), WHITE);
+  if (m_gpu != nullptr) {
+    rlActiveTextureSlot(1);
+    rlEnableTexture(m_gpu->heights().id);
+    rlActiveTextureSlot(2);
+    rlEnableTexture(m_gpu->previous_heights().id);
+  }
+
+  rlActiveTextureSlot(0);
+  rlEnableTexture(m_texture.id);
+  rlDisableBackfaceCulling();
+
+  rlEnableVertexArray(m_vao);
+  UploadSurface(render_transform);
+  rlDrawVertexArrayElements(0, 6 * (m_wave_points.size() - 1), 0);
+  rlDisableVertexArray();
+
+  rlEnableBackfaceCulling();
+  rlDisableTexture();
+
+  if (m_gpu != nullptr) {
+    rlActiveTextureSlot(1);
+    rlDisableTexture();
+    rlActiveTextureSlot(2);
+    rlDisableTexture();
+    rlActiveTextureSlot(0);
+  }
 
-  EndShaderMode();
+  rlDisableShader();
 }
 
 void InteractivePool::DrawPoints(const std::vector<Vector2> &points,
@@ -214,37 +1355,55 @@ void InteractivePool::DrawDebugWavePoints() {
   }
 }
 
-int InteractivePool::CountPointsUnderInfluence() {
-  int count = 0;
+// Wave points are evenly spaced in x, so the points whose screen x lies in
+// [min_x, max_x] form a contiguous index range [begin, end).
+void InteractivePool::GetPointRange(float min_x, float max_x, size_t &begin,
+                                    size_t &end) {
+  float step = transform.size.x / m_resolution;
+  float first_x = transform.position.x;
+  float min_i = ceilf((min_x - first_x) / step);
+  float max_i = floorf((max_x - first_x) / step);
 
-  for (const WavePoint &wave_point : m_wave_points) {
-    if (IsPointUnderInfluence(wave_point)) {
-      count++;
-    }
-  }
+  begin = (size_t)std::max(0.0f, min_i);
+  end = (size_t)std::max(0.0f,
+                         std::min((float)m_wave_points.size(), max_i + 1));
+}
 
-  return count;
+void InteractivePool::GetInteractorRange(const WaveInteractor &interactor,
+                                         size_t &begin, size_t &end) {
+  GetPointRange(interactor.position.x - interactor.radius,
+                interactor.position.x + interactor.radius, begin, end);
 }
 
-void InteractivePool::ApplyWaveInfluenceForce(WavePoint &wave_point, float dt) {
-  float dist_y;
+void InteractivePool::ApplyInteractors(float dt) {
+  size_t begin, end;
+
+  for (const WaveInteractor &interactor : m_interactors) {
+    GetInteractorRange(interactor, begin, end);
 
-  if (IsPointUnderInfluence(wave_point)) {
+    for (size_t i = begin; i < end; i++) {
+      ApplyWaveInfluenceForce(m_wave_points[i], interactor, dt);
+    }
+  }
+}
+
+void InteractivePool::ApplyWaveInfluenceForce(WavePoint &wave_point,
+                                              const WaveInteractor &interactor,
+                                              float dt) {
+  if (IsPointUnderInfluence(wave_point, interactor)) {
     float dist =
         Vector2Distance(Vector2Add(GetCenterPoint(), wave_point.final_position),
-                        GetMousePosition());
-    Vector2 direction = Vector2Normalize(
-        Vector2Subtract(Vector2Add(GetCenterPoint(), wave_point.final_position),
-                        GetMousePosition()));
+                        interactor.position);
 
     if (dist > 0) {
-      wave_point.velocity.y += std::max(0.0f, INFLUENCE_RADIUS - dist) /
-                               INFLUENCE_RADIUS * INFLUENCE_FORCE * dt;
+      wave_point.velocity.y += std::max(0.0f, interactor.radius - dist) /
+                               interactor.radius * interactor.force * dt;
     }
   }
 }
 
-bool InteractivePool::IsPointUnderInfluence(const WavePoint &wave_point) {
+bool InteractivePool::IsPointUnderInfluence(const WavePoint &wave_point,
+                                            const WaveInteractor &interactor) {
   float influence_dist_to_position_y, dist_y;
 
   influence_dist_to_position_y =
@@ -256,31 +1415,7 @@ bool InteractivePool::IsPointUnderInfluence(const WavePoint &wave_point) {
 
   return CheckCollisionPointCircle(
       Vector2Add(GetCenterPoint(), wave_point.final_position),
-      GetMousePosition(), INFLUENCE_RADIUS);
-}
-
-WaveRenderData InteractivePool::GenerateWaveRenderData() {
-  WaveRenderData wave_data;
-  float tex_step;
-
-  tex_step = 1.0f / m_resolution;
-
-  // generate a quad
-  wave_data.vertices.push_back(
-      Vector2{transform.size.x / 2, transform.size.y / 2});
-  wave_data.tex_coords.push_back(Vector2{1, 1});
-
-  for (int i = m_wave_points.size() - 1; i >= 0; i--) {
-    wave_data.vertices.push_back(Vector2{m_wave_points[i].final_position.x,
-                                         m_wave_points[i].final_position.y});
-    wave_data.tex_coords.push_back(Vector2{1 - tex_step * i, 0});
-  }
-
-  wave_data.vertices.push_back(
-      Vector2{-transform.size.x / 2, transform.size.y / 2});
-  wave_data.tex_coords.push_back(Vector2{0, 1});
-
-  return wave_data;
+      interactor.position, interactor.radius);
 }
 
 }; // namespace Rain
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+namespace Rain {
+
+static thread_local int t_thread_index = 0;
+
+JobSystem::JobSystem(int worker_count) {
+  worker_count = std::max(0, worker_count);
+
+  for (int i = 0; i < worker_count + 1; i++) {
+    m_queues.push_back(std::make_unique<TaskQueue>());
+  }
+
+  for (int i = 1; i < worker_count + 1; i++) {
+    m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    m_running = false;
+  }
+
+  m_wake.notify_all();
+
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+int JobSystem::CurrentThreadIndex() { return t_thread_index; }
+
+void JobSystem::Submit(JobCounter &counter, Job job) {
+  TaskQueue &queue = *m_queues[t_thread_index];
+
+  counter.pending++;
+
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(Task{std::move(job), &counter});
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_wake_mutex);
+    m_queued++;
+  }
+
+  m_wake.notify_one();
+}
+
+void JobSystem::ParallelFor(JobCounter &counter, size_t count,
+                            size_t chunk_size, RangeJob job) {
+  chunk_size = std::max<size_t>(1, chunk_size);
+
+  for (size_t begin = 0; begin < count; begin += chunk_size) {
+    size_t end = std::min(count, begin + chunk_size);
+
+    Submit(counter, [job, begin, end] { job(begin, end); });
+  }
+}
+
+void JobSystem::Wait(JobCounter &counter) {
+  while (counter.pending > 0) {
+    if (!TryRunTask(t_thread_index)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+bool JobSystem::TryRunTask(int index) {
+  Task task;
+
+  if (!PopTask(index, task) && !StealTask(index, task)) {
+    return false;
+  }
+
+  m_queued--;
+
+  task.job();
+  task.counter->pending--;
+
+  return true;
+}
+
+bool JobSystem::PopTask(int index, Task &task) {
+  TaskQueue &queue = *m_queues[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+
+  if (queue.tasks.empty()) {
+    return false;
+  }
+
+  task = std::move(queue.tasks.back());
+  queue.tasks.pop_back();
+
+  return true;
+}
+
+bool JobSystem::StealTask(int index, Task &task) {
+  int count = m_queues.size();
+
+  for (int i = 1; i < count; i++) {
+    TaskQueue &queue = *m_queues[(index + i) % count];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::WorkerLoop(int index) {
+  t_thread_index = index;
+
+  while (true) {
+    if (TryRunTask(index)) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+
+    m_wake.wait(lock, [this] { return !m_running || m_queued > 0; });
+
+    if (!m_running) {
+      return;
+    }
+  }
+}
+
+}; // namespace Rain
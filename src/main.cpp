@@ -1,26 +1,67 @@
 #include "application.h"
+#include "triangulation_bench.h"
+
+#include <string>
+#include <vector>
 
 int main(int argc, char *argv[]) {
-  int quit_timeout = 5 * 60;
-  int min_particles = 0;
-  int max_particles = 1000;
+  Rain::ApplicationOptions options;
+  std::vector<std::string> positional;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "--adaptive-water") {
+      options.wave_solver = Rain::WaveSolver::Implicit;
+      options.adaptive_water = true;
+    } else if (arg == "--analytic-rain") {
+      options.rain_mode = Rain::ParticleSystemMode::Analytic;
+    } else if (arg.rfind("--budget-ms=", 0) == 0) {
+      options.frame_budget_ms = std::stof(arg.substr(12));
+    } else if (arg == "--bench-triangulation") {
+      Rain::RunTriangulationBenchmark(10000);
+      return 0;
+    } else if (arg == "--gpu-water") {
+      options.wave_solver = Rain::WaveSolver::Gpu;
+    } else if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--implicit-water") {
+      options.wave_solver = Rain::WaveSolver::Implicit;
+    } else if (arg.rfind("--max-damage=", 0) == 0) {
+      options.max_damage_percent = std::stof(arg.substr(13));
+    } else if (arg == "--profile") {
+      options.profiler_overlay = true;
+    } else if (arg.rfind("--sim-rate=", 0) == 0) {
+      options.simulation_rate = std::stof(arg.substr(11));
+    } else if (arg == "--test-triangulation") {
+      return Rain::RunTriangulationTest(100000) ? 0 : 1;
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      options.worker_threads = std::stoi(arg.substr(10));
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      options.trace_path = arg.substr(8);
+    } else if (arg.rfind("--water-resolution=", 0) == 0) {
+      options.water_resolution = std::stoi(arg.substr(19));
+    } else {
+      positional.push_back(arg);
+    }
+  }
 
-  if (argc > 1) {
-    quit_timeout = std::stoi(argv[1]);
+  if (positional.size() > 0) {
+    options.quit_timeout = std::stoi(positional[0]);
   }
 
-  if (argc > 2) {
-    min_particles = std::stoi(argv[2]);
+  if (positional.size() > 1) {
+    options.min_particles = std::stoi(positional[1]);
   }
 
-  if (argc > 3) {
-    max_particles = std::stoi(argv[3]);
+  if (positional.size() > 2) {
+    options.max_particles = std::stoi(positional[2]);
   }
 
-  Rain::Application app(quit_timeout, min_particles, max_particles);
+  Rain::Application app(options);
 
   app.Init();
   app.Run();
 
-  return 0;
+  return app.exit_code();
 }
@@ -0,0 +1,127 @@
+#include "material.h"
+
+#include <cstring>
+#include <unordered_map>
+
+namespace Rain {
+
+static unsigned int s_next_material_id = 1;
+
+// Uniform values are program state, so when another material bound the same
+// shader since our last Bind every value has to be uploaded again.
+static std::unordered_map<unsigned int, unsigned int> s_program_owners;
+
+static int UniformSize(int uniform_type) {
+  switch (uniform_type) {
+  case Material::UNIFORM_MATRIX:
+    return 16;
+  case SHADER_UNIFORM_VEC2:
+  case SHADER_UNIFORM_IVEC2:
+    return 2;
+  case SHADER_UNIFORM_VEC3:
+  case SHADER_UNIFORM_IVEC3:
+    return 3;
+  case SHADER_UNIFORM_VEC4:
+  case SHADER_UNIFORM_IVEC4:
+    return 4;
+  default:
+    return 1;
+  }
+}
+
+Material::Material() : m_id(s_next_material_id++) {}
+
+Material::Material(Shader shader)
+    : m_shader(shader), m_id(s_next_material_id++) {}
+
+int Material::AddUniform(const char *name, int uniform_type) {
+  return AddUniform(GetShaderLocation(m_shader, name), uniform_type);
+}
+
+int Material::AddUniform(int location, int uniform_type) {
+  if (m_uniform_count >= MAX_UNIFORMS) {
+    TraceLog(LOG_WARNING, "MATERIAL: More than %d uniforms", MAX_UNIFORMS);
+    return -1;
+  }
+
+  Uniform &uniform = m_uniforms[m_uniform_count];
+
+  uniform.location = location;
+  uniform.type = uniform_type;
+  uniform.size = UniformSize(uniform_type);
+  uniform.dirty = false;
+  memset(uniform.value, 0, sizeof(uniform.value));
+
+  return m_uniform_count++;
+}
+
+void Material::SetFloat(int uniform, float value) {
+  SetValue(uniform, &value, sizeof(value));
+}
+
+void Material::SetInt(int uniform, int value) {
+  SetValue(uniform, &value, sizeof(value));
+}
+
+void Material::SetVector2(int uniform, Vector2 value) {
+  SetValue(uniform, &value, sizeof(value));
+}
+
+void Material::SetVector4(int uniform, Vector4 value) {
+  SetValue(uniform, &value, sizeof(value));
+}
+
+void Material::SetColor(int uniform, Color color) {
+  SetVector4(uniform, ColorNormalize(color));
+}
+
+void Material::SetMatrix(int uniform, Matrix value) {
+  SetValue(uniform, &value, sizeof(value));
+}
+
+void Material::SetValue(int uniform, const void *value, int size) {
+  if (uniform < 0 || uniform >= m_uniform_count) {
+    return;
+  }
+
+  Uniform &target = m_uniforms[uniform];
+
+  if (memcmp(target.value, value, size) != 0) {
+    memcpy(target.value, value, size);
+    target.dirty = true;
+  }
+}
+
+void Material::Bind() {
+  // rlgl's batch flushes with the default shader write its uniforms behind
+  // every material's back
+  bool upload_all = s_program_owners[m_shader.id] != m_id ||
+                    m_shader.id == rlGetShaderIdDefault();
+
+  s_program_owners[m_shader.id] = m_id;
+
+  rlEnableShader(m_shader.id);
+
+  for (int i = 0; i < m_uniform_count; i++) {
+    Uniform &uniform = m_uniforms[i];
+
+    if ((uniform.dirty || upload_all) && uniform.location >= 0) {
+      Upload(uniform);
+    }
+
+    uniform.dirty = false;
+  }
+}
+
+void Material::Upload(const Uniform &uniform) {
+  if (uniform.type == UNIFORM_MATRIX) {
+    Matrix matrix;
+
+    memcpy(&matrix, uniform.value, sizeof(matrix));
+    rlSetUniformMatrix(uniform.location, matrix);
+  } else {
+    rlSetUniform(uniform.location, uniform.value, uniform.type, 1);
+  }
+}
+
+}; // namespace Rain
@@ -1,33 +1,254 @@
 #include <particle_system.h>
+#include <profiler.h>
+#include <utils.h>
+
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace Rain {
 
+// Advances positions by velocity * dt and returns a bitmask of the lanes that
+// crossed max_y. The caller collides or resets those particles.
+#if defined(__AVX__)
+constexpr size_t PARTICLE_LANES = 8;
+
+static int IntegrateLanes(float *x, float *y, const float *vx, const float *vy,
+                          __m256 dt, __m256 max_y) {
+  __m256 px = _mm256_add_ps(_mm256_loadu_ps(x),
+                            _mm256_mul_ps(_mm256_loadu_ps(vx), dt));
+  __m256 py = _mm256_add_ps(_mm256_loadu_ps(y),
+                            _mm256_mul_ps(_mm256_loadu_ps(vy), dt));
+
+  _mm256_storeu_ps(x, px);
+  _mm256_storeu_ps(y, py);
+
+  return _mm256_movemask_ps(_mm256_cmp_ps(py, max_y, _CMP_GT_OQ));
+}
+#elif defined(__SSE2__)
+constexpr size_t PARTICLE_LANES = 4;
+
+static int IntegrateLanes(float *x, float *y, const float *vx, const float *vy,
+                          __m128 dt, __m128 max_y) {
+  __m128 px = _mm_add_ps(_mm_loadu_ps(x), _mm_mul_ps(_mm_loadu_ps(vx), dt));
+  __m128 py = _mm_add_ps(_mm_loadu_ps(y), _mm_mul_ps(_mm_loadu_ps(vy), dt));
+
+  _mm_storeu_ps(x, px);
+  _mm_storeu_ps(y, py);
+
+  return _mm_movemask_ps(_mm_cmpgt_ps(py, max_y));
+}
+#endif
+
+// Two triangles of a unit quad centered on the origin, in the same winding
+// DrawRectanglePro emits.
+static const float QUAD_VERTICES[] = {-0.5f, -0.5f, -0.5f, 0.5f,  0.5f, -0.5f,
+                                      0.5f,  -0.5f, -0.5f, 0.5f,  0.5f, 0.5f};
+
 ParticleSystem::ParticleSystem() {}
 
 ParticleSystem::ParticleSystem(ParticleSystemOptions options)
-    : m_options(options) {}
+    : m_options(options), m_active_limit(options.max_particles),
+      m_material(options.shader) {}
 
 void ParticleSystem::Init() {
-  m_particles.reserve(m_options.max_particles);
+  m_seed = rand();
+
+  if (!IsAnalytic()) {
+    m_particles.reserve(m_options.max_particles);
+    m_damage_cells.assign(DAMAGE_GRID_SIZE * DAMAGE_GRID_SIZE, 0);
+  }
 
   for (int i = 0; i < m_options.min_particles; i++) {
     SpawnParticle();
   }
+
+  if (!m_options.platform->IsHeadless()) {
+    LoadRenderData();
+  }
 }
 
 void ParticleSystem::OnDraw() {
-  BeginShaderMode(m_options.shader);
-  for (auto &particle : m_particles) {
-    DrawRectanglePro(Rectangle{particle.position.x, particle.position.y,
-                               particle.size.x, particle.size.y},
-                     Vector2{particle.size.x / 2, particle.size.y / 2},
-                     particle.rotation, particle.color);
+  RAIN_PROFILE_ZONE("ParticleSystem::OnDraw");
+
+  if (ParticleCount() == 0 || m_vao == 0) {
+    return;
+  }
+
+  m_material.SetMatrix(m_mvp_uniform, MatrixMultiply(rlGetMatrixModelview(),
+                                                     rlGetMatrixProjection()));
+
+  if (IsAnalytic()) {
+    SetAnalyticUniforms();
+  } else {
+    // Every particle moves with the same velocity, so interpolating back from
+    // the current step is a single offset
+    m_material.SetVector2(m_offset_uniform,
+                          Vector2Scale(m_options.start_velocity,
+                                       -m_last_dt * (1 - render_alpha)));
+  }
+
+  // Flush whatever rlgl has batched so far, the instanced draw bypasses it
+  rlDrawRenderBatchActive();
+
+  m_material.Bind();
+  rlEnableVertexArray(m_vao);
+
+  if (!IsAnalytic()) {
+    UploadInstances();
   }
-  EndShaderMode();
+
+  rlDrawVertexArrayInstanced(0, 6, ParticleCount());
+  rlDisableVertexArray();
+
+  rlDisableShader();
+}
+
+void ParticleSystem::Unload() {
+  if (m_vao == 0) {
+    return;
+  }
+
+  rlUnloadVertexArray(m_vao);
+  rlUnloadVertexBuffer(m_quad_vbo);
+
+  if (m_instance_vbo != 0) {
+    rlUnloadVertexBuffer(m_instance_vbo);
+  }
+
+  m_vao = m_quad_vbo = m_instance_vbo = 0;
+}
+
+void ParticleSystem::LoadRenderData() {
+  int capacity = m_options.max_particles;
+
+  if (capacity <= 0) {
+    return;
+  }
+
+  Shader shader = m_options.shader;
+  int position_loc = shader.locs[SHADER_LOC_VERTEX_POSITION];
+
+  LoadMaterial();
+
+  m_vao = rlLoadVertexArray();
+  rlEnableVertexArray(m_vao);
+
+  m_quad_vbo = rlLoadVertexBuffer(QUAD_VERTICES, sizeof(QUAD_VERTICES), false);
+  rlSetVertexAttribute(position_loc, 2, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(position_loc);
+
+  if (IsAnalytic()) {
+    rlDisableVertexArray();
+    return;
+  }
+
+  int instance_x_loc = GetShaderLocationAttrib(shader, "instanceX");
+  int instance_y_loc = GetShaderLocationAttrib(shader, "instanceY");
+
+  // x and y streams are uploaded as two blocks of one buffer, which lets the
+  // SoA arrays go to the GPU without interleaving
+  m_instance_vbo =
+      rlLoadVertexBuffer(nullptr, 2 * capacity * sizeof(float), true);
+
+  rlSetVertexAttribute(instance_x_loc, 1, RL_FLOAT, false, 0, 0);
+  rlSetVertexAttributeDivisor(instance_x_loc, 1);
+  rlEnableVertexAttribute(instance_x_loc);
+
+  rlSetVertexAttribute(instance_y_loc, 1, RL_FLOAT, false, 0,
+                       capacity * sizeof(float));
+  rlSetVertexAttributeDivisor(instance_y_loc, 1);
+  rlEnableVertexAttribute(instance_y_loc);
+
+  rlDisableVertexArray();
+}
+
+// Size, rotation and color are constant for the whole system, so they are
+// uploaded by the first Bind only.
+void ParticleSystem::LoadMaterial() {
+  float rotation = m_options.start_rotation * DEG2RAD;
+
+  m_mvp_uniform = m_material.AddUniform(
+      m_options.shader.locs[SHADER_LOC_MATRIX_MVP], Material::UNIFORM_MATRIX);
+
+  m_material.SetVector2(m_material.AddUniform("size", SHADER_UNIFORM_VEC2),
+                        m_options.start_size);
+  m_material.SetVector2(m_material.AddUniform("rotation", SHADER_UNIFORM_VEC2),
+                        Vector2{cosf(rotation), sinf(rotation)});
+  m_material.SetColor(m_material.AddUniform("color", SHADER_UNIFORM_VEC4),
+                      m_options.color);
+
+  if (!IsAnalytic()) {
+    m_offset_uniform = m_material.AddUniform("offset", SHADER_UNIFORM_VEC2);
+    return;
+  }
+
+  m_material.SetVector2(m_material.AddUniform("velocity", SHADER_UNIFORM_VEC2),
+                        m_options.start_velocity);
+  m_material.SetInt(m_material.AddUniform("seed", SHADER_UNIFORM_INT), m_seed);
+
+  m_area_uniform = m_material.AddUniform("area", SHADER_UNIFORM_VEC2);
+  m_cycle_base_uniform = m_material.AddUniform("cycleBase", SHADER_UNIFORM_INT);
+  m_cycle_fraction_uniform =
+      m_material.AddUniform("cycleFraction", SHADER_UNIFORM_FLOAT);
+}
+
+void ParticleSystem::UploadInstances() {
+  int bytes = m_particles.size() * sizeof(float);
+
+  rlUpdateVertexBuffer(m_instance_vbo, m_particles.x.data(), bytes, 0);
+  rlUpdateVertexBuffer(m_instance_vbo, m_particles.y.data(), bytes,
+                       m_options.max_particles * sizeof(float));
+}
+
+void ParticleSystem::SetAnalyticUniforms() {
+  double fraction = m_cycle_fraction;
+  uint32_t base = m_cycle_base;
+
+  if (m_options.start_velocity.y > 0 && transform.size.y > 0) {
+    fraction -= m_last_dt * (1 - render_alpha) * m_options.start_velocity.y /
+                transform.size.y;
+  }
+
+  if (fraction < 0) {
+    fraction += 1;
+    base--;
+  }
+
+  m_material.SetVector2(m_area_uniform, transform.size);
+  m_material.SetInt(m_cycle_base_uniform, (int)base);
+  m_material.SetFloat(m_cycle_fraction_uniform, fraction);
+}
+
+// The analytic clock counts whole falls separately from the progress through
+// the current one, so the shader never sees a large float time.
+void ParticleSystem::AdvanceAnalyticClock(float dt) {
+  if (m_options.start_velocity.y <= 0 || transform.size.y <= 0) {
+    return;
+  }
+
+  m_cycle_fraction += dt * m_options.start_velocity.y / transform.size.y;
+
+  double whole_cycles = floor(m_cycle_fraction);
+
+  m_cycle_base += (uint32_t)whole_cycles;
+  m_cycle_fraction -= whole_cycles;
+}
+
+size_t ParticleSystem::ParticleCount() {
+  return IsAnalytic() ? m_analytic_count : m_particles.size();
 }
 
 void ParticleSystem::OnUpdate(float dt) {
-  UpdateParticles(dt);
+  m_last_dt = dt;
+
+  if (IsAnalytic()) {
+    AdvanceAnalyticClock(dt);
+  } else {
+    UpdateParticles(dt);
+  }
 
   if (CanSpawnParticle()) {
     SpawnParticle();
@@ -35,39 +256,261 @@ void ParticleSystem::OnUpdate(float dt) {
 }
 
 void ParticleSystem::UpdateParticles(float dt) {
-  for (auto &particle : m_particles) {
-    particle.position =
-        Vector2Add(particle.position, Vector2Scale(particle.velocity, dt));
+  RAIN_PROFILE_ZONE("ParticleSystem::UpdateParticles");
+
+  size_t count = m_particles.size();
+  size_t cell_count = m_damage_cells.size();
+
+  if (m_options.jobs == nullptr || count <= UPDATE_CHUNK_SIZE) {
+    std::fill(m_damage_cells.begin(), m_damage_cells.end(), 0);
+    UpdateParticleRange(dt, 0, count, m_damage_cells.data());
+    return;
+  }
+
+  size_t chunks = (count + UPDATE_CHUNK_SIZE - 1) / UPDATE_CHUNK_SIZE;
+  JobCounter counter;
+
+  m_chunk_damage_cells.assign(chunks * cell_count, 0);
+  m_options.jobs->ParallelFor(
+      counter, count, UPDATE_CHUNK_SIZE,
+      [this, dt, cell_count](size_t begin, size_t end) {
+        uint8_t *cells = m_chunk_damage_cells.data() +
+                         begin / UPDATE_CHUNK_SIZE * cell_count;
+
+        UpdateParticleRange(dt, begin, end, cells);
+      });
+  m_options.jobs->Wait(counter);
+
+  std::fill(m_damage_cells.begin(), m_damage_cells.end(), 0);
+
+  for (size_t chunk = 0; chunk < chunks; chunk++) {
+    const uint8_t *cells = m_chunk_damage_cells.data() + chunk * cell_count;
+
+    for (size_t i = 0; i < cell_count; i++) {
+      m_damage_cells[i] |= cells[i];
+    }
+  }
+}
+
+void ParticleSystem::UpdateParticleRange(float dt, size_t begin, size_t end,
+                                         uint8_t *damage_cells) {
+  RAIN_PROFILE_ZONE("ParticleSystem::UpdateParticleRange");
+
+  float *x = m_particles.x.data();
+  float *y = m_particles.y.data();
+  const float *vx = m_particles.vx.data();
+  const float *vy = m_particles.vy.data();
+  size_t count = end;
+  size_t i = begin;
+  // Particles above the highest point of the water cannot touch it, so only
+  // those below it need the per column lookup
+  float surface_y = m_water != nullptr
+                        ? std::min(transform.size.y, m_water->min_y())
+                        : transform.size.y;
+
+#if defined(__AVX__)
+  __m256 dt_lanes = _mm256_set1_ps(dt);
+  __m256 max_y = _mm256_set1_ps(surface_y);
+#elif defined(__SSE2__)
+  __m128 dt_lanes = _mm_set1_ps(dt);
+  __m128 max_y = _mm_set1_ps(surface_y);
+#endif
+
+#if defined(__AVX__) || defined(__SSE2__)
+  for (; i + PARTICLE_LANES <= count; i += PARTICLE_LANES) {
+    int mask = IntegrateLanes(x + i, y + i, vx + i, vy + i, dt_lanes, max_y);
+
+    while (mask) {
+      int lane = __builtin_ctz(mask);
+
+      CollideParticle(i + lane);
+
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+
+    if (y[i] > surface_y) {
+      CollideParticle(i);
+    }
+  }
+
+  // Marked while the chunk is still in cache, after collisions reset drops
+  MarkDamageCells(begin, end, damage_cells);
+}
+
+void ParticleSystem::MarkDamageCells(size_t begin, size_t end,
+                                     uint8_t *cells) {
+  const float *x = m_particles.x.data();
+  const float *y = m_particles.y.data();
+  Vector2 cell_size = GetDamageCellSize();
+  float last = DAMAGE_GRID_SIZE - 1;
+
+  // Drops that drifted past the area are clamped into the edge cells
+  for (size_t i = begin; i < end; i++) {
+    int column = (int)std::clamp(x[i] / cell_size.x, 0.0f, last);
+    int row = (int)std::clamp(y[i] / cell_size.y, 0.0f, last);
+
+    cells[row * DAMAGE_GRID_SIZE + column] = 1;
+  }
+}
+
+// Called for particles below the highest point of the water or the bottom of
+// the area, resets those that hit either
+void ParticleSystem::CollideParticle(size_t index) {
+  float x = m_particles.x[index];
+  float y = m_particles.y[index];
+
+  if (m_water != nullptr && y < transform.size.y) {
+    if (y < m_water->HeightAt(x)) {
+      return;
+    }
+
+    m_water->AddImpulse(x, m_particles.vy[index]);
+  }
+
+  ResetParticle(index);
+}
+
+void ParticleSystem::SetActiveLimit(size_t limit) {
+  m_active_limit = std::min(limit, (size_t)m_options.max_particles);
+
+  if (IsAnalytic()) {
+    m_analytic_count = std::min(m_analytic_count, m_active_limit);
+  } else if (m_particles.size() > m_active_limit) {
+    m_particles.truncate(m_active_limit);
+  }
+}
+
+Rectangle ParticleSystem::GetDrawBounds() {
+  if (ParticleCount() == 0) {
+    return Rectangle{};
+  }
+
+  Vector2 velocity = m_options.start_velocity;
+  Vector2 min;
+  Vector2 max;
 
-    if (particle.position.y > transform.size.y) {
-      ResetParticle(particle);
+  if (IsAnalytic()) {
+    // Drops spawn anywhere along the top of the area and drift sideways by
+    // velocity.x for one fall
+    float drift = velocity.y > 0 ? velocity.x * transform.size.y / velocity.y
+                                 : 0;
+
+    min = Vector2{std::min(0.0f, drift), 0};
+    max = Vector2{transform.size.x + std::max(0.0f, drift), transform.size.y};
+  } else {
+    const float *x = m_particles.x.data();
+    const float *y = m_particles.y.data();
+    Vector2 offset = Vector2Scale(velocity, -m_last_dt * (1 - render_alpha));
+
+    min = max = Vector2{x[0], y[0]};
+
+    for (size_t i = 1; i < m_particles.size(); i++) {
+      min.x = std::min(min.x, x[i]);
+      min.y = std::min(min.y, y[i]);
+      max.x = std::max(max.x, x[i]);
+      max.y = std::max(max.y, y[i]);
     }
+
+    min = Vector2Add(min, offset);
+    max = Vector2Add(max, offset);
   }
+
+  Vector2 extent = GetQuadExtent();
+
+  return Rectangle{min.x - extent.x, min.y - extent.y,
+                   max.x - min.x + 2 * extent.x, max.y - min.y + 2 * extent.y};
 }
 
-Particle ParticleSystem::CreateParticle() { return Particle(); }
+// Every run of marked cells in a grid row becomes one rectangle, moved by the
+// interpolation offset and grown by a particle's extent
+void ParticleSystem::GetDrawRects(std::vector<Rectangle> &rects) {
+  if (IsAnalytic() || ParticleCount() == 0) {
+    Rectangle bounds = GetDrawBounds();
+
+    if (bounds.width > 0 && bounds.height > 0) {
+      rects.push_back(bounds);
+    }
+
+    return;
+  }
+
+  Vector2 offset = Vector2Scale(m_options.start_velocity,
+                                -m_last_dt * (1 - render_alpha));
+  Vector2 extent = GetQuadExtent();
+  Vector2 cell_size = GetDamageCellSize();
+
+  for (int row = 0; row < DAMAGE_GRID_SIZE; row++) {
+    const uint8_t *cells = m_damage_cells.data() + row * DAMAGE_GRID_SIZE;
+
+    for (int column = 0; column < DAMAGE_GRID_SIZE; column++) {
+      if (!cells[column]) {
+        continue;
+      }
+
+      int end = column + 1;
+
+      while (end < DAMAGE_GRID_SIZE && cells[end]) {
+        end++;
+      }
+
+      rects.push_back(Rectangle{
+          column * cell_size.x + offset.x - extent.x,
+          row * cell_size.y + offset.y - extent.y,
+          (end - column) * cell_size.x + 2 * extent.x,
+          cell_size.y + 2 * extent.y});
+      column = end;
+    }
+  }
+}
+
+// Half extents of a rotated particle quad
+Vector2 ParticleSystem::GetQuadExtent() {
+  float rotation = m_options.start_rotation * DEG2RAD;
+  float c = fabsf(cosf(rotation));
+  float s = fabsf(sinf(rotation));
+  Vector2 size = m_options.start_size;
+
+  return Vector2{(c * size.x + s * size.y) / 2, (s * size.x + c * size.y) / 2};
+}
+
+Vector2 ParticleSystem::GetDamageCellSize() {
+  return Vector2{std::max(transform.size.x, 1.0f) / DAMAGE_GRID_SIZE,
+                 std::max(transform.size.y, 1.0f) / DAMAGE_GRID_SIZE};
+}
 
 bool ParticleSystem::CanSpawnParticle() {
-  return m_particles.size() < m_options.max_particles &&
+  return ParticleCount() < m_active_limit &&
          RANDOM() < m_options.spawn_rate;
 }
 
 void ParticleSystem::SpawnParticle() {
-  if (CanSpawnParticle()) {
-    Particle particle = CreateParticle();
+  if (!CanSpawnParticle()) {
+    return;
+  }
+
+  if (IsAnalytic()) {
+    m_analytic_count++;
+  } else {
+    m_particles.push_back(Vector2{RANDOM() * transform.size.x, 0},
+                          m_options.start_velocity);
 
-    ResetParticle(particle);
+    size_t index = m_particles.size() - 1;
 
-    m_particles.push_back(particle);
+    MarkDamageCells(index, index + 1, m_damage_cells.data());
   }
 }
 
-void ParticleSystem::ResetParticle(Particle &particle) {
-  particle.position = Vector2{RANDOM() * transform.size.x, 0};
-  particle.velocity = m_options.start_velocity;
-  particle.rotation = m_options.start_rotation;
-  particle.color = m_options.color;
-  particle.size = m_options.start_size;
+void ParticleSystem::ResetParticle(size_t index) {
+  m_particles.x[index] = ThreadRandom() * transform.size.x;
+  m_particles.y[index] = 0;
+  m_particles.vx[index] = m_options.start_velocity.x;
+  m_particles.vy[index] = m_options.start_velocity.y;
 }
 
-}; // namespace Rain
\ No newline at end of file
+}; // namespace Rain
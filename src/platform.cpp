@@ -0,0 +1,39 @@
+#include "platform.h"
+
+namespace Rain {
+
+bool RaylibPlatform::HasInput() {
+  Vector2 mouse_delta = GetMouseDelta();
+
+  return mouse_delta.x != 0 || mouse_delta.y != 0 ||
+         IsMouseButtonPressed(MOUSE_BUTTON_LEFT) ||
+         IsMouseButtonPressed(MOUSE_BUTTON_RIGHT) || GetKeyPressed() != 0;
+}
+
+HeadlessPlatform::HeadlessPlatform(const HeadlessPlatformOptions &options)
+    : m_options(options) {
+  NextFrame();
+  m_frame = 0;
+}
+
+// Sweeps the mouse back and forth just above the bottom of the screen, where
+// the water surface starts, so the pool sees a moving interactor.
+void HeadlessPlatform::NextFrame() {
+  float t = m_frame * m_options.frame_time;
+
+  m_mouse_position = {
+      (0.5f + 0.5f * sinf(t * 0.5f)) * m_options.screen_width,
+      m_options.screen_height - 50.0f};
+
+  m_frame++;
+}
+
+bool HeadlessPlatform::IsKeyPressed(int key) {
+  if (key != KEY_SPACE || m_options.duck_spawn_interval <= 0) {
+    return false;
+  }
+
+  return m_frame % m_options.duck_spawn_interval == 0;
+}
+
+}; // namespace Rain
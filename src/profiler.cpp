@@ -0,0 +1,174 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace Rain {
+
+static thread_local void *t_ring = nullptr;
+
+static uint64_t SteadyNanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+Profiler &Profiler::Get() {
+  static Profiler profiler;
+
+  return profiler;
+}
+
+Profiler::Profiler() : m_epoch_ns(SteadyNanoseconds()) {}
+
+uint64_t Profiler::Now() const { return SteadyNanoseconds() - m_epoch_ns; }
+
+void Profiler::Record(const ProfileEvent &event) {
+  Ring &ring = ThreadRing();
+  size_t head = ring.head.load(std::memory_order_relaxed);
+
+  if (head - ring.tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+    return;
+  }
+
+  ring.events[head & (RING_CAPACITY - 1)] = event;
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::RecordTrack(const char *track, const ProfileEvent &event) {
+  int index = -1;
+
+  {
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+    for (size_t i = 0; i < m_track_names.size(); i++) {
+      if (m_track_names[i] == track) {
+        index = i;
+      }
+    }
+
+    if (index < 0) {
+      index = m_track_names.size();
+      m_track_names.push_back(track);
+    }
+  }
+
+  AddCollected(event, index);
+}
+
+void Profiler::Collect() {
+  std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+  for (std::unique_ptr<Ring> &ring : m_rings) {
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+
+    for (; tail != head; tail++) {
+      AddCollected(ring->events[tail & (RING_CAPACITY - 1)], ring->track);
+    }
+
+    ring->tail.store(tail, std::memory_order_release);
+  }
+}
+
+std::vector<ZoneSummary> Profiler::Summaries() const {
+  std::vector<ZoneSummary> summaries;
+  std::vector<double> sorted;
+
+  for (const auto &[name, stats] : m_zones) {
+    size_t count = std::min(stats.count, ZONE_WINDOW);
+    double sum = 0;
+
+    sorted.assign(stats.samples_ms, stats.samples_ms + count);
+
+    for (double sample : sorted) {
+      sum += sample;
+    }
+
+    size_t p99_index = (size_t)(0.99 * (count - 1) + 0.5);
+
+    std::nth_element(sorted.begin(), sorted.begin() + p99_index,
+                     sorted.end());
+    summaries.push_back(
+        ZoneSummary{name, stats.count, sum / count, sorted[p99_index]});
+  }
+
+  std::sort(summaries.begin(), summaries.end(),
+            [](const ZoneSummary &a, const ZoneSummary &b) {
+              return a.name < b.name;
+            });
+
+  return summaries;
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "w");
+
+  if (file == nullptr) {
+    return false;
+  }
+
+  fprintf(file, "{\"traceEvents\":[\n");
+
+  {
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+    for (size_t i = 0; i < m_track_names.size(); i++) {
+      fprintf(file,
+              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%zu,"
+              "\"args\":{\"name\":\"%s\"}},\n",
+              i, m_track_names[i].c_str());
+    }
+  }
+
+  // Once the trace is full, m_trace_next is the oldest event
+  for (size_t i = 0; i < m_trace.size(); i++) {
+    const TraceEvent &trace = m_trace[(m_trace_next + i) % m_trace.size()];
+
+    fprintf(file,
+            "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,"
+            "\"ts\":%.3f,\"dur\":%.3f}%s\n",
+            trace.event.name, trace.track, trace.event.start_ns / 1000.0,
+            (trace.event.end_ns - trace.event.start_ns) / 1000.0,
+            i + 1 < m_trace.size() ? "," : "");
+  }
+
+  fprintf(file, "]}\n");
+
+  return fclose(file) == 0;
+}
+
+Profiler::Ring &Profiler::ThreadRing() {
+  if (t_ring == nullptr) {
+    auto ring = std::make_unique<Ring>();
+
+    std::lock_guard<std::mutex> lock(m_rings_mutex);
+
+    ring->track = m_track_names.size();
+    m_track_names.push_back("thread " + std::to_string(m_rings.size()));
+    t_ring = ring.get();
+    m_rings.push_back(std::move(ring));
+  }
+
+  return *static_cast<Ring *>(t_ring);
+}
+
+void Profiler::AddCollected(const ProfileEvent &event, int track) {
+  m_zones[event.name].Add((event.end_ns - event.start_ns) / 1e6);
+
+  if (m_trace.size() < MAX_TRACE_EVENTS) {
+    m_trace.push_back(TraceEvent{event, track});
+  } else {
+    m_trace[m_trace_next] = TraceEvent{event, track};
+    m_trace_next = (m_trace_next + 1) % MAX_TRACE_EVENTS;
+  }
+}
+
+void Profiler::ZoneStats::Add(double ms) {
+  samples_ms[next] = ms;
+  next = (next + 1) % ZONE_WINDOW;
+  count++;
+}
+
+}; // namespace Rain
@@ -0,0 +1,43 @@
+#include "quality_governor.h"
+
+#include <algorithm>
+
+namespace Rain {
+
+QualityGovernor::QualityGovernor(const QualityGovernorOptions &options)
+    : m_options(options) {}
+
+bool QualityGovernor::AddFrame(double frame_ms) {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  m_window_sum_ms += frame_ms;
+  m_window_frames++;
+
+  if (m_window_frames < m_options.window) {
+    return false;
+  }
+
+  double average_ms = m_window_sum_ms / m_window_frames;
+  float level = m_level;
+
+  m_window_sum_ms = 0;
+  m_window_frames = 0;
+
+  if (average_ms > m_options.budget_ms * m_options.high_ratio) {
+    level = std::max(m_options.min_level, m_level - m_options.step);
+  } else if (average_ms < m_options.budget_ms * m_options.low_ratio) {
+    level = std::min(1.0f, m_level + m_options.step);
+  }
+
+  if (level == m_level) {
+    return false;
+  }
+
+  m_level = level;
+
+  return true;
+}
+
+}; // namespace Rain
@@ -1,24 +1,37 @@
 #include "rigidbody_2d.h"
-#include "entity.h"
-#include "raymath.h"
 
 namespace Rain {
-Rigidbody2d::Rigidbody2d(Entity *entity) : m_parent(entity) {}
 
-void Rigidbody2d::Init() {}
+Rigidbody2d CreateRigidbody2d(float mass) {
+  Rigidbody2d body;
 
-void Rigidbody2d::OnDraw() {}
+  body.mass = mass;
+  body.inverse_mass = mass > 0 ? 1.0f / mass : 0.0f;
 
-void Rigidbody2d::OnUpdate(float dt) {
-  m_velocity = Vector2Add(m_velocity, Vector2Scale(m_acceleration, dt));
-  m_parent->transform.position =
-      Vector2Add(m_parent->transform.position, Vector2Scale(m_velocity, dt));
+  return body;
+}
 
-  m_acceleration = Vector2Zero();
+void AddForce(Rigidbody2d &body, Vector2 force) {
+  body.acceleration =
+      Vector2Add(body.acceleration, Vector2Scale(force, body.inverse_mass));
 }
 
-void Rigidbody2d::AddForce(Vector2 force) {
-  m_acceleration =
-      Vector2Add(m_acceleration, Vector2Scale(force, 1.0f / m_mass));
+void ApplyImpulse(Rigidbody2d &body, Vector2 impulse) {
+  body.velocity =
+      Vector2Add(body.velocity, Vector2Scale(impulse, body.inverse_mass));
 }
-}; // namespace Rain
\ No newline at end of file
+
+void IntegrateRigidbodies(Rigidbody2d *bodies, Transform *transforms,
+                          size_t begin, size_t end, float dt) {
+  for (size_t i = begin; i < end; i++) {
+    Rigidbody2d &body = bodies[i];
+
+    body.velocity =
+        Vector2Add(body.velocity, Vector2Scale(body.acceleration, dt));
+    transforms[i].position =
+        Vector2Add(transforms[i].position, Vector2Scale(body.velocity, dt));
+    body.acceleration = Vector2Zero();
+  }
+}
+
+}; // namespace Rain
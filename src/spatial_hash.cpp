@@ -0,0 +1,95 @@
+#include "spatial_hash.h"
+
+#include <cmath>
+
+namespace Rain {
+
+SpatialHash::SpatialHash(float cell_size) : m_cell_size(cell_size) {}
+
+void SpatialHash::Insert(int id, Vector2 center) {
+  if ((size_t)id >= m_entries.size()) {
+    m_entries.resize(id + 1);
+  }
+
+  Add(id, CellOf(center));
+}
+
+void SpatialHash::Move(int id, Vector2 center) {
+  uint64_t cell = CellOf(center);
+
+  if (m_entries[id].cell == cell) {
+    return;
+  }
+
+  Remove(id);
+  Add(id, cell);
+}
+
+void SpatialHash::Clear() {
+  m_cells.clear();
+  m_entries.clear();
+}
+
+void SpatialHash::QueryNeighbors(Vector2 center,
+                                 std::vector<int> &ids) const {
+  int cell_x = CellCoordinate(center.x);
+  int cell_y = CellCoordinate(center.y);
+
+  for (int y = cell_y - 1; y <= cell_y + 1; y++) {
+    for (int x = cell_x - 1; x <= cell_x + 1; x++) {
+      auto cell = m_cells.find(CellKey(x, y));
+
+      if (cell != m_cells.end()) {
+        ids.insert(ids.end(), cell->second.begin(), cell->second.end());
+      }
+    }
+  }
+}
+
+uint64_t SpatialHash::CellKey(int cell_x, int cell_y) const {
+  return ((uint64_t)(uint32_t)cell_x << 32) | (uint32_t)cell_y;
+}
+
+uint64_t SpatialHash::CellOf(Vector2 center) const {
+  return CellKey(CellCoordinate(center.x), CellCoordinate(center.y));
+}
+
+// Positions past the int range and NaN would make the cast undefined, they
+// are clamped into the outermost cells instead
+int SpatialHash::CellCoordinate(float position) const {
+  float cell = floorf(position / m_cell_size);
+
+  if (!(cell > -MAX_CELL)) {
+    return -MAX_CELL;
+  }
+
+  return cell < MAX_CELL ? (int)cell : MAX_CELL;
+}
+
+void SpatialHash::Add(int id, uint64_t cell) {
+  std::vector<int> &ids = m_cells[cell];
+
+  m_entries[id] = Entry{cell, ids.size()};
+  ids.push_back(id);
+}
+
+void SpatialHash::Remove(int id) {
+  Entry &entry = m_entries[id];
+  auto cell = m_cells.find(entry.cell);
+  std::vector<int> &ids = cell->second;
+
+  // Swap the last id of the cell into the freed slot
+  int last = ids.back();
+
+  ids[entry.slot] = last;
+  m_entries[last].slot = entry.slot;
+  ids.pop_back();
+
+  // Objects drifting across the plane would otherwise leave a trail of empty
+  // cells behind
+  if (ids.empty()) {
+    m_cells.erase(cell);
+  }
+}
+
+}; // namespace Rain
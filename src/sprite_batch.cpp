@@ -0,0 +1,138 @@
+#include "sprite_batch.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace Rain {
+
+static Shader DefaultShader() {
+  return Shader{rlGetShaderIdDefault(), rlGetShaderLocsDefault()};
+}
+
+SpriteBatch::SpriteBatch(Texture texture)
+    : m_texture(texture), m_material(DefaultShader()) {
+  Shader shader = m_material.shader();
+  int position_loc = shader.locs[SHADER_LOC_VERTEX_POSITION];
+  int texcoord_loc = shader.locs[SHADER_LOC_VERTEX_TEXCOORD01];
+  int color_loc = shader.locs[SHADER_LOC_VERTEX_COLOR];
+  std::vector<unsigned short> indices(6 * MAX_QUADS);
+
+  // Quads are emitted as top-left, bottom-left, bottom-right, top-right
+  for (int i = 0; i < MAX_QUADS; i++) {
+    unsigned short first = 4 * i;
+
+    indices[6 * i + 0] = first;
+    indices[6 * i + 1] = first + 1;
+    indices[6 * i + 2] = first + 2;
+    indices[6 * i + 3] = first;
+    indices[6 * i + 4] = first + 2;
+    indices[6 * i + 5] = first + 3;
+  }
+
+  m_mvp_uniform = m_material.AddUniform(shader.locs[SHADER_LOC_MATRIX_MVP],
+                                        Material::UNIFORM_MATRIX);
+  m_material.SetColor(m_material.AddUniform(
+                          shader.locs[SHADER_LOC_COLOR_DIFFUSE],
+                          SHADER_UNIFORM_VEC4),
+                      WHITE);
+  m_material.SetInt(m_material.AddUniform(shader.locs[SHADER_LOC_MAP_ALBEDO],
+                                          SHADER_UNIFORM_INT),
+                    0);
+
+  m_vao = rlLoadVertexArray();
+  rlEnableVertexArray(m_vao);
+
+  m_vbo = rlLoadVertexBuffer(nullptr, 4 * MAX_QUADS * sizeof(SpriteVertex),
+                             true);
+  rlSetVertexAttribute(position_loc, 2, RL_FLOAT, false, sizeof(SpriteVertex),
+                       offsetof(SpriteVertex, x));
+  rlEnableVertexAttribute(position_loc);
+  rlSetVertexAttribute(texcoord_loc, 2, RL_FLOAT, false, sizeof(SpriteVertex),
+                       offsetof(SpriteVertex, u));
+  rlEnableVertexAttribute(texcoord_loc);
+  rlSetVertexAttribute(color_loc, 4, RL_UNSIGNED_BYTE, true,
+                       sizeof(SpriteVertex), offsetof(SpriteVertex, color));
+  rlEnableVertexAttribute(color_loc);
+
+  m_ebo = rlLoadVertexBufferElement(
+      indices.data(), indices.size() * sizeof(unsigned short), false);
+
+  rlDisableVertexArray();
+}
+
+SpriteBatch::~SpriteBatch() {
+  if (m_vao == 0) {
+    return;
+  }
+
+  rlUnloadVertexArray(m_vao);
+  rlUnloadVertexBuffer(m_vbo);
+  rlUnloadVertexBuffer(m_ebo);
+}
+
+void SpriteBatch::Add(Rectangle source, Rectangle dest, Vector2 origin,
+                      float rotation, Color tint) {
+  float sin_r = sinf(rotation * DEG2RAD);
+  float cos_r = cosf(rotation * DEG2RAD);
+  float left = -origin.x;
+  float top = -origin.y;
+  float right = left + dest.width;
+  float bottom = top + dest.height;
+  float u0 = source.x / m_texture.width;
+  float v0 = source.y / m_texture.height;
+  float u1 = (source.x + source.width) / m_texture.width;
+  float v1 = (source.y + source.height) / m_texture.height;
+
+  auto corner = [&](float x, float y, float u, float v) {
+    return SpriteVertex{dest.x + x * cos_r - y * sin_r,
+                        dest.y + x * sin_r + y * cos_r, u, v, tint};
+  };
+
+  m_vertices.push_back(corner(left, top, u0, v0));
+  m_vertices.push_back(corner(left, bottom, u0, v1));
+  m_vertices.push_back(corner(right, bottom, u1, v1));
+  m_vertices.push_back(corner(right, top, u1, v0));
+}
+
+void SpriteBatch::Flush() {
+  RAIN_PROFILE_ZONE("SpriteBatch::Flush");
+
+  int quad_count = m_vertices.size() / 4;
+
+  if (quad_count == 0) {
+    return;
+  }
+
+  m_material.SetMatrix(m_mvp_uniform, MatrixMultiply(rlGetMatrixModelview(),
+                                                     rlGetMatrixProjection()));
+
+  // Flush whatever rlgl has batched so far, the quads are drawn directly
+  rlDrawRenderBatchActive();
+
+  m_material.Bind();
+  rlActiveTextureSlot(0);
+  rlEnableTexture(m_texture.id);
+  rlDisableBackfaceCulling();
+  rlEnableVertexArray(m_vao);
+
+  for (int first = 0; first < quad_count; first += MAX_QUADS) {
+    DrawQuads(m_vertices.data() + 4 * first,
+              std::min(MAX_QUADS, quad_count - first));
+  }
+
+  rlDisableVertexArray();
+  rlEnableBackfaceCulling();
+  rlDisableTexture();
+  rlDisableShader();
+
+  m_vertices.clear();
+}
+
+void SpriteBatch::DrawQuads(const SpriteVertex *vertices, int quad_count) {
+  rlUpdateVertexBuffer(m_vbo, vertices, 4 * quad_count * sizeof(SpriteVertex),
+                       0);
+  rlDrawVertexArrayElements(0, 6 * quad_count, 0);
+}
+
+}; // namespace Rain
@@ -0,0 +1,83 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Rain {
+
+int TextureAtlas::Add(Image image) {
+  m_images.push_back(image);
+  m_regions.push_back(Rectangle{0, 0, (float)image.width,
+                                (float)image.height});
+
+  return m_images.size() - 1;
+}
+
+int TextureAtlas::Add(const char *file_name) {
+  return Add(LoadImage(file_name));
+}
+
+void TextureAtlas::Build(int width) {
+  std::vector<int> order(m_images.size());
+
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return m_images[a].height > m_images[b].height;
+  });
+
+  for (const Image &image : m_images) {
+    width = std::max(width, image.width + 2 * PADDING);
+  }
+
+  int x = 0;
+  int shelf_y = 0;
+  int shelf_height = 0;
+
+  for (int id : order) {
+    int slot_width = m_images[id].width + 2 * PADDING;
+    int slot_height = m_images[id].height + 2 * PADDING;
+
+    if (x + slot_width > width) {
+      shelf_y += shelf_height;
+      x = 0;
+      shelf_height = 0;
+    }
+
+    m_regions[id].x = x + PADDING;
+    m_regions[id].y = shelf_y + PADDING;
+
+    x += slot_width;
+    shelf_height = std::max(shelf_height, slot_height);
+  }
+
+  Image atlas = GenImageColor(width, std::max(1, shelf_y + shelf_height),
+                              BLANK);
+
+  for (size_t id = 0; id < m_images.size(); id++) {
+    Image &image = m_images[id];
+
+    ImageDraw(&atlas, image,
+              Rectangle{0, 0, (float)image.width, (float)image.height},
+              m_regions[id], WHITE);
+    UnloadImage(image);
+  }
+
+  m_images.clear();
+  m_texture = LoadTextureFromImage(atlas);
+  UnloadImage(atlas);
+}
+
+void TextureAtlas::Unload() {
+  for (const Image &image : m_images) {
+    UnloadImage(image);
+  }
+
+  m_images.clear();
+
+  if (m_texture.id != 0) {
+    UnloadTexture(m_texture);
+    m_texture = Texture{};
+  }
+}
+
+}; // namespace Rain
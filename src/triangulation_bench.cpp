@@ -0,0 +1,198 @@
+#include "triangulation_bench.h"
+#include "renderer.h"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+
+namespace Rain {
+
+// Same shape as the interactive pool: two bottom corners and a wavy surface
+static std::vector<Vector2> CreateWaterPolygon(int resolution) {
+  std::vector<Vector2> points;
+  float width = 2920, height = 500;
+
+  points.push_back(Vector2{width / 2, height / 2});
+
+  for (int i = resolution; i >= 0; i--) {
+    float x = -width / 2 + width * i / resolution;
+
+    points.push_back(Vector2{x, -height / 2 + 10 * sinf(x / 60)});
+  }
+
+  points.push_back(Vector2{-width / 2, height / 2});
+
+  return points;
+}
+
+static std::vector<Vector2> CreateConvexPolygon(int count) {
+  std::vector<Vector2> points;
+
+  for (int i = 0; i < count; i++) {
+    float angle = 2 * PI * i / count;
+
+    points.push_back(Vector2{200 * cosf(angle), 200 * sinf(angle)});
+  }
+
+  return points;
+}
+
+// Random polygon monotone in x: both chains run between the leftmost and
+// rightmost vertex at random heights, so they may cross
+static std::vector<Vector2> CreateMonotonePolygon(std::mt19937 &rng) {
+  std::uniform_real_distribution<float> coordinate(0, 20);
+  int count = 3 + rng() % 14;
+  std::vector<float> xs;
+  std::vector<Vector2> forward, backward, points;
+
+  for (int i = 0; i < count; i++) {
+    xs.push_back(coordinate(rng));
+  }
+
+  std::sort(xs.begin(), xs.end());
+
+  for (int i = 1; i < count - 1; i++) {
+    Vector2 point = {xs[i], coordinate(rng)};
+
+    (rng() % 2 == 0 ? forward : backward).push_back(point);
+  }
+
+  points.push_back(Vector2{xs[0], coordinate(rng)});
+  points.insert(points.end(), forward.begin(), forward.end());
+  points.push_back(Vector2{xs[count - 1], coordinate(rng)});
+  points.insert(points.end(), backward.rbegin(), backward.rend());
+  std::rotate(points.begin(), points.begin() + rng() % points.size(),
+              points.end());
+
+  return points;
+}
+
+static std::vector<N>
+TriangulateWithEarcut(const std::vector<Vector2> &points) {
+  std::vector<std::vector<Point>> polygon(1);
+
+  for (const Vector2 &point : points) {
+    polygon[0].push_back({point.x, point.y});
+  }
+
+  return mapbox::earcut<N>(polygon);
+}
+
+static double GetTrianglesArea(const std::vector<Vector2> &points,
+                               const std::vector<N> &indices) {
+  double area = 0;
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    area += fabs(Cross(points[indices[i]], points[indices[i + 1]],
+                       points[indices[i + 2]])) /
+            2;
+  }
+
+  return area;
+}
+
+// Whether Triangulate covers the polygon with as many triangles and as much
+// area as earcut. Overlapping triangles add area, so a wrong diagonal shows.
+static bool MatchesEarcut(std::vector<Vector2> &points) {
+  TriangulationScratch scratch;
+  const std::vector<N> &indices =
+      Triangulate(points.data(), points.size(), scratch);
+  std::vector<N> expected = TriangulateWithEarcut(points);
+  double area = GetTrianglesArea(points, indices);
+  double expected_area = GetTrianglesArea(points, expected);
+
+  return indices.size() == expected.size() &&
+         fabs(area - expected_area) <= 1e-4 * std::max(1.0, expected_area);
+}
+
+static double MeasureEarcut(std::vector<Vector2> &points, int iterations) {
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++) {
+    std::vector<std::vector<Point>> polygon;
+    std::vector<Point> outer;
+
+    for (const Vector2 &point : points) {
+      outer.push_back({point.x, point.y});
+    }
+
+    polygon.push_back(outer);
+
+    std::vector<N> indices = mapbox::earcut<N>(polygon);
+
+    std::reverse(indices.begin(), indices.end());
+    checksum += indices.size();
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  return checksum > 0 ? iterations / elapsed.count() : 0;
+}
+
+static double MeasureTriangulate(std::vector<Vector2> &points,
+                                 int iterations) {
+  TriangulationScratch scratch;
+  size_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < iterations; i++) {
+    checksum += Triangulate(points.data(), points.size(), scratch).size();
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  return checksum > 0 ? iterations / elapsed.count() : 0;
+}
+
+static void ReportPolygon(const char *name, std::vector<Vector2> points,
+                          int iterations) {
+  if (!MatchesEarcut(points)) {
+    std::cout << name << " (" << points.size()
+              << " vertices): triangulate disagrees with earcut" << std::endl;
+    return;
+  }
+
+  double earcut_rate = MeasureEarcut(points, iterations);
+  double fast_rate = MeasureTriangulate(points, iterations);
+
+  std::cout << name << " (" << points.size() << " vertices): earcut "
+            << earcut_rate << " polygons/s, triangulate " << fast_rate
+            << " polygons/s, " << fast_rate / earcut_rate << "x" << std::endl;
+}
+
+void RunTriangulationBenchmark(int iterations) {
+  ReportPolygon("water", CreateWaterPolygon(300), iterations);
+  ReportPolygon("water", CreateWaterPolygon(3000), iterations / 10);
+  ReportPolygon("convex", CreateConvexPolygon(64), iterations);
+}
+
+bool RunTriangulationTest(int polygons) {
+  std::mt19937 rng(1);
+
+  for (int i = 0; i < polygons; i++) {
+    std::vector<Vector2> points = CreateMonotonePolygon(rng);
+
+    if (!MatchesEarcut(points)) {
+      std::cout << "triangulate disagrees with earcut on polygon " << i
+                << ":";
+
+      for (const Vector2 &point : points) {
+        std::cout << " (" << point.x << ", " << point.y << ")";
+      }
+
+      std::cout << std::endl;
+
+      return false;
+    }
+  }
+
+  std::cout << polygons << " random monotone polygons match earcut"
+            << std::endl;
+
+  return true;
+}
+
+}; // namespace Rain
@@ -0,0 +1,71 @@
+#include <water_surface.h>
+
+#include <job_system.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Rain {
+
+// Floats per 64 byte cache line
+static const size_t LINE_FLOATS = 16;
+
+WaterSurface::WaterSurface(int thread_count)
+    : m_thread_count(std::max(thread_count, 1)), m_min_y(INFINITY) {}
+
+void WaterSurface::Sync(float min_x, float column_width, const float *ys,
+                        size_t count) {
+  if (count != m_ys.size()) {
+    m_row_stride = (count + LINE_FLOATS - 1) / LINE_FLOATS * LINE_FLOATS;
+    m_impulses.assign(count, 0);
+    m_thread_impulses.assign(m_row_stride * m_thread_count, 0);
+  } else {
+    std::fill(m_impulses.begin(), m_impulses.end(), 0);
+
+    for (int thread = 0; thread < m_thread_count; thread++) {
+      float *row = m_thread_impulses.data() + thread * m_row_stride;
+
+      for (size_t i = 0; i < count; i++) {
+        m_impulses[i] += row[i];
+      }
+
+      std::fill(row, row + count, 0);
+    }
+  }
+
+  m_min_x = min_x;
+  m_column_width = column_width;
+  m_ys.assign(ys, ys + count);
+  m_min_y = count > 0 ? *std::min_element(m_ys.begin(), m_ys.end()) : INFINITY;
+}
+
+float WaterSurface::HeightAt(float x) const {
+  if (m_ys.size() < 2) {
+    return INFINITY;
+  }
+
+  float column = (x - m_min_x) / m_column_width;
+
+  if (!(column >= 0) || column >= m_ys.size() - 1) {
+    return INFINITY;
+  }
+
+  size_t i = (size_t)column;
+  float t = column - i;
+
+  return m_ys[i] + (m_ys[i + 1] - m_ys[i]) * t;
+}
+
+void WaterSurface::AddImpulse(float x, float impulse) {
+  float column = roundf((x - m_min_x) / m_column_width);
+
+  if (!(column >= 0) || column >= m_ys.size()) {
+    return;
+  }
+
+  size_t row = JobSystem::CurrentThreadIndex() % m_thread_count;
+
+  m_thread_impulses[row * m_row_stride + (size_t)column] += impulse;
+}
+
+}; // namespace Rain